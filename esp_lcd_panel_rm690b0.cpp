@@ -1,18 +1,42 @@
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <array>
+#include <atomic>
 #include <memory>
+#include <optional>
+#include <span>
 #include <thread>
-#include <vector>
+#include <variant>
 #include <chrono>
+#include <cmath>
 
 
+#include "esp_attr.h"
+#include "esp_cache.h"
 #include "esp_check.h"
 #include "esp_lcd_panel_interface.h"
 #include "esp_lcd_panel_io_interface.h"
 #include "driver/gpio.h"
 #include "hal/gpio_types.h"
 #include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
 #include "esp_lcd_panel_commands.h"
 #include "esp_lcd_panel_dev.h"
 #include "esp_lcd_rm690b0.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "nvs.h"
+
+#if CONFIG_APPTRACE_SV_ENABLE
+#include "SEGGER_SYSVIEW.h"
+#endif
 
 constexpr auto TAG = "panel.rm690b0";
 
@@ -20,28 +44,28 @@ constexpr auto LOW = 0;
 constexpr auto HIGH = 1;
 
 namespace {
-    struct RM690B0Panel {
-        esp_lcd_panel_t base{};
-        esp_lcd_panel_io_handle_t io = nullptr;
-        uint8_t brightness = 0;
-        gpio_num_t reset_gpio_num = GPIO_NUM_NC;
-        gpio_num_t en_gpio_num = GPIO_NUM_NC;
-        uint8_t x_gap = 0;
-        uint8_t y_gap = 0;
-        uint8_t bits_per_pixel{};
-        bool swap_xy = false;
-        bool mirror_x = false;
-        bool mirror_y = false;
-        lcd_rgb_element_order_t rgb_ele_order = LCD_RGB_ELEMENT_ORDER_RGB;
-        bool grayscale = false;
-    };
-
-    RM690B0Panel* panel_cast(const esp_lcd_panel_t* panel) {
-        return __containerof(panel, RM690B0Panel, base);
-    }
-
     constexpr int32_t command_prefix = 0x02000000UL;
     constexpr int32_t pixel_prefix = 0x32000000UL;
+    constexpr int32_t read_prefix = 0x03000000UL;
+
+    // What differs between the buses the RM690B0 can be wired to
+    struct BusBackend {
+        rm690b0_bus_t bus;
+        const char* name;
+        bool qspi_framing; // Commands go out in the 32-bit QSPI instruction phase, rather than as their address
+        bool swap_rgb565;  // RGB565 pixels arrive low byte first, as they are in memory, so the panel swaps them
+    };
+
+    // Indexed by rm690b0_bus_t
+    constexpr std::array bus_backends = {
+        BusBackend{RM690B0_BUS_QSPI, "qspi", true, true},
+        BusBackend{RM690B0_BUS_SPI, "spi", false, true},
+        BusBackend{RM690B0_BUS_OCTAL_SPI, "octal_spi", false, true},
+        BusBackend{RM690B0_BUS_I80_8BIT, "i80_8bit", false, true},
+        // Each RGB565 pixel is one 16-bit bus cycle, which puts its bytes in order already
+        BusBackend{RM690B0_BUS_I80_16BIT, "i80_16bit", false, false},
+        BusBackend{RM690B0_BUS_DSI, "dsi", false, true},
+    };
 
     constexpr uint8_t color_3_bits_per_pixel = 0b00110011;
     constexpr uint8_t grayscale_8_bits_per_pixel = 0b00010001;
@@ -53,9 +77,14 @@ namespace {
     constexpr uint8_t lcd_cmd_unknown_0x2400 = 0x24;
     constexpr uint8_t lcd_cmd_unknown_0x5B00 = 0x5B;
     constexpr uint8_t lcd_cmd_write_display_brightness = 0x51;
+    constexpr uint8_t lcd_cmd_read_display_brightness = 0x52;
+    constexpr uint8_t lcd_cmd_read_power_mode = 0x0A;
+    constexpr uint8_t lcd_cmd_read_madctl = 0x0B;
+    constexpr uint8_t lcd_cmd_read_colmod = 0x0C;
     constexpr uint8_t lcd_cmd_set_disp_mode = 0xC2;
     constexpr uint8_t lcd_cmd_cmd_mode_switch = 0xFE;
     constexpr uint8_t lcd_cmd_interface_pixel_format_option = 0x80;
+    constexpr uint8_t max_wire_bits_per_pixel = 24;
 
     constexpr uint8_t rotation_normal = 0;
     constexpr uint8_t rotation_mirror_y = 0x10;
@@ -63,12 +92,25 @@ namespace {
     constexpr uint8_t rotation_minus90 = 0x30;
     constexpr uint8_t rotation_plus90 = 0x60;
 
+    // The scan direction bit that reverses the order of frame memory lines, i.e. the scroll axis
+    constexpr uint8_t scan_reverse_lines = rotation_mirror_y;
+
+    constexpr uint8_t swap_rgb565_bytes = 0b00010000;
+
+    // RDDPM bits that tell us the panel is up and showing an image
+    constexpr uint8_t power_mode_sleep_out = 0b00010000;
+    constexpr uint8_t power_mode_display_on = 0b00000100;
+
+    // Windows must start on, and span, a multiple of this many columns and rows
+    constexpr int column_alignment = 2;
+    constexpr int row_alignment = 2;
+
     constexpr uint8_t rbg_element_order_rgb = 0;
     constexpr uint8_t rbg_element_order_bgr = 0b00001000;
 
     // This struct is used to convert commands from the structure described in
-    // RM690B0's docs to the one used esp_lcd_panel_io_spi. It should work for
-    // non-spi interfaces (esp_lcd_panel_io_i2c etc.), but I don't have the means to test it.
+    // RM690B0's docs to the one used esp_lcd_panel_io_spi. Commands are always built in this QSPI form;
+    // the bus backend (see BusBackend) turns them into what other buses send just before they go out.
     //
     // RM690B0's command structure is four bytes. These need to be combined into
     // a single 32-bit integer for the esp_lcd_panel_io_spi interface. After these
@@ -85,385 +127,4216 @@ namespace {
     // I do the same in the code to keep things consistent.
     //
     // Some commands require a delay before other commands can be processed.
+    //
+    // Parameters are stored inline (no command we send takes more than six, which the compiler checks
+    // for constant commands, and transmit() for the others), so building an LCDCmd never touches the heap. This matters for draw_bitmap,
+    // which builds three of them on every flush.
     // NOLINTBEGIN(*-magic-numbers)
+    constexpr std::chrono::milliseconds command_delay(const uint8_t command_addr) noexcept {
+        using namespace std::literals;
+
+        switch (command_addr) {
+        case LCD_CMD_SLPIN:
+            return 5ms;
+
+        case LCD_CMD_SLPOUT:
+            return 120ms;
+
+        case LCD_CMD_DISPON:
+        case lcd_cmd_set_disp_mode:
+            return 10ms;
+
+        default:
+            return 0ms;
+        }
+    }
+
     struct LCDCmd {
-        LCDCmd(const uint8_t command_addr, const std::vector<uint8_t>& param) noexcept :
+        static constexpr size_t max_params = 6;
+        static constexpr size_t refused = max_params + 1; // param_count of a command with too many parameters
+
+        // Deliberately not constexpr: a constant LCDCmd with too many parameters, like an entry of
+        // default_init_cmds, fails to compile. One built at run time is refused rather than sent cut short.
+        static size_t too_many_params(const uint8_t command_addr, const size_t count) noexcept {
+            ESP_LOGE(TAG, "Command %#04x has %zu parameters, more than %zu", command_addr, count, max_params);
+            return refused;
+        }
+
+        constexpr LCDCmd(const uint8_t command_addr, const std::initializer_list<uint8_t> params) noexcept :
             lcd_cmd(command_prefix + (static_cast<int32_t>(command_addr) << 8)),
-            param(param) {
-            using namespace std::literals;
+            param_count(params.size() <= max_params ? params.size() : too_many_params(command_addr, params.size())),
+            delay(command_delay(command_addr)) {
+            std::copy_n(params.begin(), std::min(param_count, max_params), param.begin());
+        }
+
+        constexpr LCDCmd(const uint8_t command_addr, const std::initializer_list<uint8_t> params,
+                         const std::chrono::milliseconds delay) noexcept :
+            LCDCmd(command_addr, params) {
+            this->delay = delay;
+        }
+
+        constexpr LCDCmd() noexcept = default;
+
+        [[nodiscard]] constexpr bool valid() const noexcept { return param_count <= max_params; }
+
+        int32_t lcd_cmd{};
+        std::array<uint8_t, max_params> param{};
+        size_t param_count{};
+        std::chrono::milliseconds delay{};
+    };
+
+    // NOLINTEND(*-magic-numbers)
+
+    // A GPIO level change that is part of a power-up or reset sequence
+    struct PinStep {
+        gpio_num_t pin;
+        uint32_t level;
+        std::chrono::milliseconds delay;
+    };
+
+    // A command from the user's init table. The table outlives the panel, so we only keep a pointer.
+    struct UserCmd {
+        const rm690b0_lcd_init_cmd_t* cmd;
+        std::chrono::milliseconds delay;
+    };
+
+    // One step of a reset or init sequence: either drive a pin or send a command.
+    // All carry the time the controller needs before it accepts the next step.
+    using SequenceStep = std::variant<PinStep, LCDCmd, UserCmd>;
+
+    constexpr std::chrono::milliseconds step_delay(const SequenceStep& step) {
+        return std::visit([](const auto& s) { return s.delay; }, step);
+    }
+
+    // What a reset, init or sleep sequence is made of. Its steps are worked out one at a time, from the
+    // pins, the command tables in flash and the user's init table, so running one allocates nothing.
+    struct SequencePlan {
+        bool reset = false;             // Pulse the reset pin, if there is one
+        bool init = false;              // Power up and send the init commands
+        std::optional<uint8_t> command; // Then a command without parameters, e.g. SLPIN
+    };
+
+    // A reset or init sequence running in the background. Each step is executed from an
+    // esp_timer callback, and the timer is re-armed for the step's delay instead of
+    // sleeping, so the caller's task is free while the controller wakes up.
+    struct AsyncSequence {
+        esp_timer_handle_t timer = nullptr;
+        SequencePlan plan;
+        size_t next_step = 0;
+        esp_lcd_panel_rm690b0_done_cb_t done_cb = nullptr;
+        void* user_ctx = nullptr;
+        std::atomic<bool> busy = false;
+
+        bool init = false; // Whether this is an init sequence, for rm690b0_stats_t::init_time_us
+        int64_t start_us = 0;
+    };
+
+    // State of the tearing effect (TE) input. The TE ISR updates the timing fields under `lock`.
+    struct TearingEffect {
+        gpio_num_t gpio_num = GPIO_NUM_NC;
+        bool sync = false;
+        SemaphoreHandle_t edge = nullptr;
+        esp_lcd_panel_rm690b0_vsync_cb_t vsync_cb = nullptr;
+        void* vsync_ctx = nullptr;
+
+        portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+        int64_t last_edge_us = 0;
+        uint32_t period_us = 0;
+        uint32_t edge_count = 0;
+    };
+
+    struct HeapCapsDeleter {
+        void operator()(void* ptr) const noexcept {
+            heap_caps_free(ptr);
+        }
+    };
+
+    using DmaBuffer = std::unique_ptr<uint8_t, HeapCapsDeleter>;
+
+    // Phases of a flush, as SystemView user events when SystemView tracing is enabled
+    enum TracePoint : uint8_t {
+        trace_flush,       // draw_bitmap or batch commit, until the last pixel is queued
+        trace_window,      // CASET/RASET/RAMWR
+        trace_te_wait,     // Waiting for the TE pulse
+        trace_color,       // Queuing or streaming the pixels
+    };
+
+    void trace_start([[maybe_unused]] const TracePoint point) {
+#if CONFIG_APPTRACE_SV_ENABLE
+        SEGGER_SYSVIEW_OnUserStart(point);
+#endif
+    }
+
+    void trace_stop([[maybe_unused]] const TracePoint point) {
+#if CONFIG_APPTRACE_SV_ENABLE
+        SEGGER_SYSVIEW_OnUserStop(point);
+#endif
+    }
+
+    // Trace the enclosing scope as `point`
+    struct TraceScope {
+        TracePoint point;
+
+        explicit TraceScope(const TracePoint point) : point(point) { trace_start(point); }
+        ~TraceScope() { trace_stop(point); }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+    };
+
+    // What a queued color transfer was for, so the transfer-done ISR knows what to do when it completes
+    enum TransferTag : uint8_t {
+        transfer_band_buffer = 1 << 0, // Sent from a streaming buffer, which is free again afterwards
+        transfer_end_of_draw = 1 << 1, // Last transfer of a draw_bitmap call
+        transfer_fill = 1 << 2,        // Sent from the fill buffer
+        transfer_pm_lock = 1 << 3,     // Holds a reference on the power manager's PM lock
+    };
+
+    // Color transfers queued on the panel IO.
+    //
+    // The IO calls on_color_trans_done once per tx_color, in submission order, but tells us nothing
+    // about which transfer finished. So we tag transfers as we submit them, and the ISR reads the tags
+    // back in the same order. The ring must be larger than the IO's transaction queue depth.
+    struct ColorTransfers {
+        static constexpr size_t max_in_flight = 64;
+
+        bool io_callbacks_claimed = false;
+        std::array<uint8_t, max_in_flight> tags{};
+
+        // When the flush a transfer tagged transfer_end_of_draw ends started, and how many pixel bytes it sent
+        std::array<int64_t, max_in_flight> flush_start_us{};
+        std::array<uint32_t, max_in_flight> flush_bytes{};
+        // The caller's buffer, if the transfer ends a pipelined flush
+        std::array<const void*, max_in_flight> flush_buffers{};
+        const void* flush_buffer = nullptr; // Of the pipelined flush being drawn, if any
+        std::atomic<uint32_t> submitted = 0; // Only written by the drawing task
+        std::atomic<uint32_t> completed = 0; // Only written by the ISR
+
+        // Pixel bytes of each transfer, and running totals of those submitted and completed
+        std::array<uint32_t, max_in_flight> sizes{};
+        std::atomic<uint32_t> submitted_bytes = 0;
+        std::atomic<uint32_t> completed_bytes = 0;
+        SemaphoreHandle_t drained = nullptr; // Given when no transfer is left in flight, once created
+
+        rm690b0_event_callbacks_t cbs{};
+        void* user_ctx = nullptr;
+    };
+
+    // Where flush time goes. Totals are only written by the drawing task at the end of each flush, and
+    // latencies by the ISR, both under the lock. The current flush's figures are the drawing task's own.
+    struct Stats {
+        portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+        rm690b0_stats_t totals{};
+        uint64_t latency_total_us = 0;
+        uint64_t latency_bytes = 0;
+        std::atomic<uint32_t> commands = 0;
+
+        int64_t flush_start_us = 0;
+        uint64_t flush_window_us = 0;
+        uint64_t flush_te_wait_us = 0;
+        uint64_t flush_pixel_bytes = 0;
+    };
+
+    // Ping-pong buffers in internal DMA-capable RAM. Pixels that live elsewhere (e.g. a PSRAM framebuffer)
+    // are copied into one buffer while the other is on the wire.
+    struct Streaming {
+        size_t buffer_size = 0;
+        std::array<DmaBuffer, 2> buffers;
+        size_t next_buffer = 0;
+        SemaphoreHandle_t free_buffers = nullptr;
+    };
+
+    // A small DMA buffer full of one color, sent over and over to fill an area without a buffer of its size.
+    // It is only repainted once none of its transfers are in flight.
+    struct Fill {
+        static constexpr size_t buffer_size = 4032; // Whole pixels at 1, 2 and 3 bytes per pixel
+
+        DmaBuffer buffer;
+        std::array<uint8_t, 3> pixel{}; // The color the buffer holds
+        size_t pixel_size = 0;          // 0 until the buffer holds a color
+        std::atomic<uint32_t> in_flight = 0;
+        SemaphoreHandle_t idle = nullptr; // Given when the last transfer in flight is done
+
+        bool detect = false; // Send draws of a single color from the fill buffer
+    };
+
+    // A column/row address window in controller coordinates. Unlike the esp_lcd API, the end
+    // coordinates are *included* in the window.
+    struct AddressWindow {
+        int x_start;
+        int y_start;
+        int x_end;
+        int y_end;
+
+        bool operator==(const AddressWindow&) const = default;
+    };
+
+    // A rectangle in esp_lcd panel coordinates: like the esp_lcd API, x_end and y_end are *excluded*.
+    struct Rect {
+        int x_start;
+        int y_start;
+        int x_end;
+        int y_end;
+
+        [[nodiscard]] int width() const { return x_end - x_start; }
+        [[nodiscard]] int height() const { return y_end - y_start; }
+        [[nodiscard]] size_t area() const { return static_cast<size_t>(width()) * height(); }
+        [[nodiscard]] bool empty() const { return x_end <= x_start || y_end <= y_start; }
+
+        bool operator==(const Rect&) const = default;
+    };
+
+    Rect bounding_box(const Rect& a, const Rect& b) {
+        return {
+            std::min(a.x_start, b.x_start), std::min(a.y_start, b.y_start),
+            std::max(a.x_end, b.x_end), std::max(a.y_end, b.y_end)
+        };
+    }
+
+    // Pixels for one window: `rows` rows of `row_bytes` each, `stride` bytes apart.
+    // A contiguous buffer is a single "row" holding the whole window.
+    struct PixelSource {
+        const uint8_t* data;
+        size_t row_bytes;
+        size_t stride;
+        size_t rows;
+
+        [[nodiscard]] size_t size() const { return row_bytes * rows; }
+        [[nodiscard]] bool contiguous() const { return rows == 1 || row_bytes == stride; }
+
+        // Copy `length` bytes of row `row`, starting `offset` bytes into the row
+        void copy(const size_t row, const size_t offset, uint8_t* dst, const size_t length) const {
+            std::memcpy(dst, data + row * stride + offset, length);
+        }
+    };
+
+    // The controller wants windows to start on an even column and row, and to span an even number of
+    // columns and rows. This source grows the caller's window (`inner`) to an aligned one (`outer`),
+    // taking the extra edge pixels from a full-screen framebuffer. Edge pixels that fall outside the
+    // framebuffer (e.g. off-glass columns when the gap is odd) are sent as zeros.
+    struct AlignedSource {
+        const uint8_t* data; // The caller's pixels for `inner`, contiguous
+        Rect inner;
+        Rect outer;
+        const uint8_t* framebuffer;
+        int fb_width;
+        int fb_height;
+        size_t pixel_size;
+
+        size_t row_bytes;
+        size_t rows;
+
+        AlignedSource(const uint8_t* data, const Rect& inner, const Rect& outer, const uint8_t* framebuffer,
+                      const int fb_width, const int fb_height, const size_t pixel_size) :
+            data(data), inner(inner), outer(outer), framebuffer(framebuffer), fb_width(fb_width),
+            fb_height(fb_height), pixel_size(pixel_size), row_bytes(outer.width() * pixel_size),
+            rows(outer.height()) {}
+
+        [[nodiscard]] size_t size() const { return row_bytes * rows; }
+
+        void copy(const size_t row, const size_t offset, uint8_t* dst, const size_t length) const {
+            const int y = outer.y_start + static_cast<int>(row);
+            size_t position = 0; // Byte position within the row of the next segment
+
+            // Copy the part of the next `bytes` bytes of the row that falls within [offset, offset + length)
+            auto segment = [&](const uint8_t* src, const size_t bytes) {
+                const size_t begin = std::max(position, offset);
+                const size_t end = std::min(position + bytes, offset + length);
+
+                if (begin < end) {
+                    if (src) {
+                        std::memcpy(dst + begin - offset, src + begin - position, end - begin);
+                    } else {
+                        std::memset(dst + begin - offset, 0, end - begin);
+                    }
+                }
+
+                position += bytes;
+            };
+
+            auto from_framebuffer = [&](const int x_start, const int x_end) {
+                if (y < 0 || y >= fb_height) {
+                    segment(nullptr, (x_end - x_start) * pixel_size);
+                    return;
+                }
+
+                const int inside_start = std::clamp(x_start, 0, fb_width);
+                const int inside_end = std::clamp(x_end, 0, fb_width);
+
+                segment(nullptr, (inside_start - x_start) * pixel_size);
+                segment(framebuffer + (static_cast<size_t>(y) * fb_width + inside_start) * pixel_size,
+                        (inside_end - inside_start) * pixel_size);
+                segment(nullptr, (x_end - inside_end) * pixel_size);
+            };
+
+            if (y >= inner.y_start && y < inner.y_end) {
+                const size_t inner_row_bytes = inner.width() * pixel_size;
+
+                from_framebuffer(outer.x_start, inner.x_start);
+                segment(data + (y - inner.y_start) * inner_row_bytes, inner_row_bytes);
+                from_framebuffer(inner.x_end, outer.x_end);
+            } else {
+                from_framebuffer(outer.x_start, outer.x_end);
+            }
+        }
+    };
+
+    // The caller's contiguous pixels in another format, converted as they are gathered into a streaming buffer.
+    // Offsets and lengths are in bytes of the panel's format, and always cover whole pixels.
+    struct ConvertedSource {
+        const uint8_t* data;
+        rm690b0_pixel_format_t src_format;
+        rm690b0_pixel_format_t dst_format;
+        size_t src_pixel_size;
+        size_t dst_pixel_size;
+
+        size_t row_bytes;
+        size_t rows = 1;
+
+        [[nodiscard]] size_t size() const { return row_bytes * rows; }
+
+        void copy(size_t, const size_t offset, uint8_t* dst, const size_t length) const {
+            esp_lcd_panel_rm690b0_convert_pixels(src_format, data + offset / dst_pixel_size * src_pixel_size,
+                                                 dst_format, dst, length / dst_pixel_size);
+        }
+    };
+
+    template <size_t PixelSize>
+    void reverse_pixels(uint8_t* pixels, const size_t count) {
+        for (size_t front = 0, back = count - 1; front < back; ++front, --back) {
+            std::swap_ranges(pixels + front * PixelSize, pixels + (front + 1) * PixelSize, pixels + back * PixelSize);
+        }
+    }
+
+    // Reverse the order of `count` pixels in place, keeping the bytes of each pixel in order
+    void reverse_pixels(uint8_t* pixels, const size_t count, const size_t pixel_size) {
+        switch (pixel_size) {
+        case 1:
+            std::reverse(pixels, pixels + count);
+            break;
+
+        case 2:
+            reverse_pixels<2>(pixels, count);
+            break;
+
+        case 3:
+            reverse_pixels<3>(pixels, count); // NOLINT(*-magic-numbers)
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // A window of another source, mirrored for the orientations the controller can't scan itself:
+    // rows in reverse order with `flip_y`, pixels within each row with `flip_x`. The underlying source
+    // may cut the window into rows differently (e.g. one "row" for a contiguous buffer), so it is read
+    // by byte position within the window.
+    template <typename Source>
+    struct FlippedSource {
+        const Source& source;
+        size_t row_bytes; // Of a window row
+        size_t rows;
+        size_t pixel_size;
+        bool flip_x;
+        bool flip_y;
+
+        [[nodiscard]] size_t size() const { return row_bytes * rows; }
+
+        void copy(const size_t row, const size_t offset, uint8_t* dst, const size_t length) const {
+            const size_t source_row = flip_y ? rows - 1 - row : row;
+            const size_t source_offset = flip_x ? row_bytes - offset - length : offset;
+
+            copy_bytes(source_row * row_bytes + source_offset, dst, length);
+
+            if (flip_x) {
+                reverse_pixels(dst, length / pixel_size, pixel_size);
+            }
+        }
+
+    private:
+        void copy_bytes(size_t position, uint8_t* dst, size_t length) const {
+            while (length) {
+                const size_t row = position / source.row_bytes;
+                const size_t offset = position % source.row_bytes;
+                const size_t chunk = std::min(length, source.row_bytes - offset);
+
+                source.copy(row, offset, dst, chunk);
+                position += chunk;
+                dst += chunk;
+                length -= chunk;
+            }
+        }
+    };
+
+    // Dirty rectangles collected during a frame, drawn from the caller's framebuffer at commit time.
+    struct DirtyBatch {
+        static constexpr size_t max_rects = 32;
+
+        // At 80 MHz QSPI a pixel byte takes 25 ns on the wire, and setting up a window (CASET, RASET
+        // and RAMWR, each a polling transaction with CS setup) takes roughly 50 us.
+        static constexpr uint32_t default_window_overhead_bytes = 2048;
+
+        bool open = false;
+        const uint8_t* framebuffer = nullptr;
+        int width = 0;
+        int height = 0;
+        uint32_t window_overhead_bytes = default_window_overhead_bytes;
+
+        std::array<Rect, max_rects> rects{};
+        size_t count = 0;
+
+        rm690b0_batch_stats_t stats{};
+    };
+
+    // Commands held back between cmd_batch_begin and cmd_batch_commit, so that a set of changes reaches
+    // the panel together. Register writes where only the last value matters replace earlier ones.
+    // The owner holds the bus for the whole batch, and only it touches the commands.
+    struct CommandBatch {
+        static constexpr size_t max_cmds = 16;
+
+        std::atomic<TaskHandle_t> owner = nullptr; // The task with the batch open, if any
+        std::array<LCDCmd, max_cmds> cmds{};
+        size_t count = 0;
+    };
+
+    // Commands sent by other tasks while the bus is claimed, sent by the claimer when it lets go of the bus.
+    // A bounded multi-producer, single-consumer ring (after Dmitry Vyukov's): producers reserve a slot by
+    // advancing `tail`, and the slot's sequence number tells the consumer when its command has been written.
+    class CommandQueue {
+    public:
+        static constexpr size_t capacity = 16; // Must be a power of two
+
+        CommandQueue() noexcept {
+            for (size_t i = 0; i < capacity; ++i) {
+                slots[i].sequence = i;
+            }
+        }
+
+        // From any task. False if the queue is full.
+        bool push(const LCDCmd& cmd) {
+            size_t pos = tail;
+
+            while (true) {
+                Slot& slot = slots[pos & (capacity - 1)];
+                const size_t sequence = slot.sequence;
+
+                if (sequence == pos) {
+                    if (tail.compare_exchange_weak(pos, pos + 1)) {
+                        slot.cmd = cmd;
+                        slot.sequence = pos + 1;
+                        return true;
+                    }
+                } else if (sequence < pos) {
+                    return false;
+                } else {
+                    pos = tail;
+                }
+            }
+        }
+
+        // Only from the task that has claimed the bus. False if the queue is empty.
+        bool pop(LCDCmd& cmd) {
+            Slot& slot = slots[head & (capacity - 1)];
+
+            if (slot.sequence != head + 1) {
+                return false;
+            }
+
+            cmd = slot.cmd;
+            slot.sequence = head + capacity;
+            ++head;
+
+            return true;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return slots[head & (capacity - 1)].sequence != head + 1;
+        }
+
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence;
+            LCDCmd cmd;
+        };
+
+        std::array<Slot, capacity> slots;
+        std::atomic<size_t> tail = 0;
+        size_t head = 0;
+    };
+
+    // Only one task talks to the controller at a time: a draw, a fade step or a command. Commands from
+    // other tasks wait in `queue` until the current owner is done, so they never land between RAMWR and
+    // its pixels, and nobody else has to block.
+    struct Bus {
+        std::atomic<bool> claimed = false;
+        std::atomic<TaskHandle_t> owner = nullptr;
+        std::atomic<uint32_t> waiters = 0;
+        SemaphoreHandle_t released = nullptr; // Given when the bus is let go while somebody waits for it
+        CommandQueue queue;
+    };
+
+    // Full-screen framebuffers owned by the driver, in PSRAM and in the panel's pixel format. Each starts on
+    // a cache line and spans whole cache lines, so writing one back never touches memory around it.
+    struct Framebuffers {
+        static constexpr size_t max_count = 3;
+
+        std::array<DmaBuffer, max_count> buffers;
+        size_t count = 0;
+        int width = 0;
+        int height = 0;
+        bool direct_dma = false; // The panel IO's DMA reads PSRAM, so draws need no copy
+    };
+
+    // A draw handed to the transfer task by esp_lcd_panel_rm690b0_flush_async()
+    struct FlushJob {
+        Rect rect;
+        const void* data; // Null asks the task to stop
+    };
+
+    // Pipelined flush: a transfer task, usually on the other core, draws queued flushes while the caller
+    // renders the next one. Buffers go back to the caller from on_color_trans_done.
+    struct Pipeline {
+        static constexpr uint32_t stack_size = 4096;
+        static constexpr UBaseType_t default_priority = 5;
+        static constexpr size_t default_queue_depth = 2;
+
+        TaskHandle_t task = nullptr;
+        QueueHandle_t jobs = nullptr;
+        SemaphoreHandle_t stopped = nullptr;
+
+        esp_lcd_panel_rm690b0_flush_done_cb_t done_cb = nullptr;
+        void* user_ctx = nullptr;
+    };
+
+    // Hardware scroll area, in frame memory lines along the scroll axis, in the panel's orientation
+    struct Scrolling {
+        bool defined = false;
+        uint16_t top_fixed = 0;
+        uint16_t lines = 0;
+        uint16_t bottom_fixed = 0;
+        uint16_t offset = 0;
+    };
+
+    // A brightness ramp, stepped by a periodic esp_timer. Steps are only sent while nobody else has the bus;
+    // otherwise the latest one waits in `pending` until the bus is let go.
+    struct Fade {
+        static constexpr uint64_t step_period_us = 10'000;
+
+        esp_timer_handle_t timer = nullptr;
+        SemaphoreHandle_t lock = nullptr; // Held by a step, and while a fade is started or cancelled
+        std::atomic<bool> active = false;
+
+        uint8_t from = 0;
+        uint8_t to = 0;
+        int64_t start_us = 0;
+        uint32_t duration_us = 0;
+        rm690b0_fade_curve_t curve = RM690B0_FADE_LINEAR;
+
+        std::atomic<int> pending = -1; // Level still to be sent, or -1
+        esp_lcd_panel_rm690b0_done_cb_t done_cb = nullptr;
+        void* user_ctx = nullptr;
+    };
+
+    // Partial display mode: only rows [y_start, y_end) of the panel are shown, the rest is dark
+    struct PartialMode {
+        bool on = false;
+        int y_start = 0;
+        int y_end = 0;
+    };
+
+    // What the controller's sleep and display state is, from the commands we sent, and the power manager's
+    // settings. The sleep timer puts an idle panel to sleep, no sooner than the controller allows.
+    struct Power {
+        static constexpr auto wake_delay = std::chrono::milliseconds(5); // After SLPOUT, before other commands
+        static constexpr int64_t sleep_in_delay_us = 5'000;               // After SLPIN, before SLPOUT
+        static constexpr int64_t min_awake_us = 120'000;                  // After SLPOUT, before SLPIN
+
+        std::atomic<bool> asleep = true; // The controller comes out of reset asleep, with the display off
+        bool display_on = false;
+        std::atomic<int64_t> changed_us = 0; // When the latest SLPIN or SLPOUT was sent
+
+        bool managed = false;
+        bool use_pm_lock = false;
+        uint64_t auto_sleep_us = 0;
+        esp_timer_handle_t timer = nullptr;
+        esp_pm_lock_handle_t pm_lock = nullptr;
+        std::atomic<int64_t> last_draw_us = 0;
+        std::atomic<bool> sleep_requested = false;
+    };
+
+    struct RM690B0Panel {
+        esp_lcd_panel_t base{};
+        esp_lcd_panel_io_handle_t io = nullptr;
+        const BusBackend* backend = bus_backends.data();
+        uint8_t brightness = 0;
+        gpio_num_t reset_gpio_num = GPIO_NUM_NC;
+        gpio_num_t en_gpio_num = GPIO_NUM_NC;
+        uint8_t x_gap = 0;
+        uint8_t y_gap = 0;
+        uint8_t bits_per_pixel{};
+        bool swap_xy = false;
+        bool mirror_x = false;
+        bool mirror_y = false;
+        int width = 0;  // Before swap_xy, or 0 if unknown
+        int height = 0;
+        lcd_rgb_element_order_t rgb_ele_order = LCD_RGB_ELEMENT_ORDER_RGB;
+        bool grayscale = false;
+
+        // The window last programmed with CASET/RASET. RAMWR always restarts at the window's
+        // origin, so if the next draw uses the same window we can skip the address commands.
+        AddressWindow window{};
+        bool window_valid = false;
+
+        AsyncSequence sequence;
+        TearingEffect te;
+        ColorTransfers transfers;
+        Stats stats;
+        Streaming streaming;
+        Fill fill;
+        DirtyBatch batch;
+
+        // Format of the pixels passed to draw_bitmap, if they need converting to the panel's format
+        bool convert = false;
+        rm690b0_pixel_format_t source_format = RM690B0_PIXEL_FORMAT_RGB565;
+
+        // Full-screen framebuffer that supplies edge pixels when draw_bitmap grows a window to the
+        // controller's alignment. Null if alignment is left to the caller.
+        struct {
+            const uint8_t* framebuffer = nullptr;
+            int width = 0;
+            int height = 0;
+        } align;
 
-            switch (command_addr) {
-            case LCD_CMD_SLPIN:
-                delay = 5ms;
-                break;
+        // User init table replacing default_init_cmds, if any
+        std::span<const rm690b0_lcd_init_cmd_t> init_cmds;
 
-            case LCD_CMD_SLPOUT:
-                delay = 120ms;
-                break;
+        CommandBatch commands;
+        Scrolling scrolling;
+        PartialMode partial;
+        bool idle = false;
+        Power power;
+
+        Fade fade;
+        Bus bus;
+        Pipeline pipeline;
+        Framebuffers framebuffers;
+    };
+
+    RM690B0Panel* panel_cast(const esp_lcd_panel_t* panel) {
+        return __containerof(panel, RM690B0Panel, base);
+    }
+
+    // This command sequence (and the comments) is based on LilyGo's code by Lewis He:
+    // https://github.com/Xinyuan-LilyGO/LilyGo-Display-IDF/blob/master/main/initSequence.c,
+
+    // It lives in flash, with its delays spelled out, so init builds nothing but the step list.
+    // NOLINTBEGIN(*-magic-numbers)
+    constexpr std::array default_init_cmds = {
+        LCDCmd{lcd_cmd_cmd_mode_switch, {0x20}}, // CMD Mode Switch: Manufacture Command Set Page Panel
+
+        // The 0x2400 and 0x5B00 commands  came from the LilyGo code.
+        // I cannot find mention of them in the RM9690B0 docs and don't know what they do.
+        // All I can say is that the display stays dark if I remove them, so here they stay.
+        LCDCmd{lcd_cmd_unknown_0x2400, {0x80}}, // SPI write RAM
+        LCDCmd{lcd_cmd_unknown_0x5B00, {0x2E}}, //! 230918:SWIRE FOR BV6804
+
+        LCDCmd{lcd_cmd_cmd_mode_switch, {0x00}}, // CMD Mode Switch: User Command Set (UCS = CMD1)
+        LCDCmd{lcd_cmd_set_disp_mode, {0x00}, std::chrono::milliseconds(10)}, // set_DISP Mode: internal timing
+        LCDCmd{LCD_CMD_TEON, {0x00}}, // Tearing effect pin on
+        LCDCmd{LCD_CMD_SLPOUT, {}, std::chrono::milliseconds(120)}, // Sleep out
+        LCDCmd{LCD_CMD_DISPON, {}, std::chrono::milliseconds(10)}, // Display on
+    };
+
+    // NOLINTEND(*-magic-numbers)
+
+    // The command phase of `qspi_cmd` on the panel's bus: as is on QSPI, the bare command address otherwise
+    int bus_command(const esp_lcd_panel_t* panel, const int32_t qspi_cmd) {
+        return panel_cast(panel)->backend->qspi_framing ? qspi_cmd : qspi_cmd >> 8 & 0xFF; // NOLINT(*-magic-numbers)
+    }
+
+    void arm_sleep_timer(const Power& power, uint64_t delay_us);
+
+    // Keep track of the controller's power state, whichever path a command took: init sequence, user table or call
+    void note_power_command(const esp_lcd_panel_t* panel, const uint8_t command_addr) {
+        Power& power = panel_cast(panel)->power;
+
+        switch (command_addr) {
+        case LCD_CMD_SLPIN:
+        case LCD_CMD_SLPOUT:
+            power.asleep = command_addr == LCD_CMD_SLPIN;
+            power.changed_us = esp_timer_get_time();
+
+            if (!power.asleep && power.managed && power.auto_sleep_us) {
+                arm_sleep_timer(power, power.auto_sleep_us);
+            }
+            break;
+
+        case LCD_CMD_DISPON:
+        case LCD_CMD_DISPOFF:
+            power.display_on = command_addr == LCD_CMD_DISPON;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // Send a command without waiting for its delay
+    esp_err_t transmit(const esp_lcd_panel_t* panel, const LCDCmd& cmd) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        const int lcd_cmd = bus_command(panel, cmd.lcd_cmd);
+        ESP_RETURN_ON_FALSE(cmd.valid(), ESP_ERR_INVALID_ARG, TAG, "command %#010x has too many parameters", lcd_cmd);
+
+        if (cmd.param_count == 1) {
+            ESP_LOGD(TAG, "Sending command %#010x with parameter 0x%x", lcd_cmd, cmd.param.at(0));
+        } else {
+            ESP_LOGD(TAG, "Sending command %#010x with %zu parameters", lcd_cmd, cmd.param_count);
+        }
+
+        ++rm690b0->stats.commands;
+        const esp_err_t ret = rm690b0->io->tx_param(rm690b0->io, lcd_cmd, cmd.param_count ? cmd.param.data() : nullptr,
+                                                    cmd.param_count);
+        if (ret == ESP_OK) {
+            note_power_command(panel, cmd.lcd_cmd >> 8 & 0xFF); // NOLINT(*-magic-numbers)
+        }
+
+        return ret;
+    }
+
+    // Send a command from the user's init table, which may have more parameters than an LCDCmd can hold
+    esp_err_t transmit(const esp_lcd_panel_t* panel, const rm690b0_lcd_init_cmd_t& cmd) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        const int lcd_cmd = bus_command(panel, command_prefix + (static_cast<int32_t>(cmd.cmd) << 8));
+
+        ESP_LOGD(TAG, "Sending command %#010x with %zu parameters", lcd_cmd, cmd.data_bytes);
+
+        ++rm690b0->stats.commands;
+        const esp_err_t ret =
+            rm690b0->io->tx_param(rm690b0->io, lcd_cmd, cmd.data_bytes ? cmd.data : nullptr, cmd.data_bytes);
+        if (ret == ESP_OK) {
+            note_power_command(panel, cmd.cmd);
+        }
+
+        return ret;
+    }
+
+    // Commands that set a register, where a later write makes an earlier one pointless
+    // NOLINTBEGIN(*-magic-numbers)
+    constexpr bool last_write_wins(const int32_t lcd_cmd) {
+        switch (lcd_cmd >> 8 & 0xFF) {
+        case LCD_CMD_MADCTL:
+        case LCD_CMD_COLMOD:
+        case LCD_CMD_CASET:
+        case LCD_CMD_RASET:
+        case LCD_CMD_INVON:
+        case LCD_CMD_INVOFF:
+        case lcd_cmd_interface_pixel_format_option:
+        case lcd_cmd_write_display_brightness:
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    // NOLINTEND(*-magic-numbers)
+
+    // Hold `cmd` back until the command batch is committed
+    esp_err_t queue_command(CommandBatch& batch, const LCDCmd& cmd) {
+        if (last_write_wins(cmd.lcd_cmd)) {
+            const auto end = batch.cmds.begin() + static_cast<std::ptrdiff_t>(batch.count);
+
+            // INVON and INVOFF write the same setting
+            const auto same_register = [&cmd](const LCDCmd& queued) {
+                const auto inversion = [](const int32_t lcd_cmd) {
+                    return lcd_cmd == command_prefix + (LCD_CMD_INVON << 8) ||
+                           lcd_cmd == command_prefix + (LCD_CMD_INVOFF << 8);
+                };
+
+                return queued.lcd_cmd == cmd.lcd_cmd || (inversion(queued.lcd_cmd) && inversion(cmd.lcd_cmd));
+            };
+
+            if (const auto queued = std::find_if(batch.cmds.begin(), end, same_register); queued != end) {
+                *queued = cmd;
+                return ESP_OK;
+            }
+        }
+
+        ESP_RETURN_ON_FALSE(batch.count < CommandBatch::max_cmds, ESP_ERR_NO_MEM, TAG, "command batch full");
+        batch.cmds.at(batch.count++) = cmd;
+
+        return ESP_OK;
+    }
+
+    // Send the fade's pending brightness, if any. The caller must have claimed the bus.
+    esp_err_t apply_pending_brightness(const esp_lcd_panel_t* panel) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        const int level = rm690b0->fade.pending.exchange(-1);
+        if (level < 0 || level == rm690b0->brightness) {
+            return ESP_OK;
+        }
+
+        rm690b0->brightness = static_cast<uint8_t>(level);
+        return transmit(panel, LCDCmd{lcd_cmd_write_display_brightness, {rm690b0->brightness}});
+    }
+
+    // Send a command and wait for its delay. The caller must have claimed the bus.
+    esp_err_t send_now(const esp_lcd_panel_t* panel, const LCDCmd& cmd) {
+        const esp_err_t ret = transmit(panel, cmd);
+
+        if (cmd.delay.count() > 0) {
+            std::this_thread::sleep_for(cmd.delay);
+        }
+
+        return ret;
+    }
+
+    bool owns_bus(const esp_lcd_panel_t* panel) {
+        return panel_cast(panel)->bus.owner == xTaskGetCurrentTaskHandle();
+    }
+
+    // Whether the calling task has a command batch open, and so holds the bus until it commits
+    bool batching(const esp_lcd_panel_t* panel) {
+        return panel_cast(panel)->commands.owner == xTaskGetCurrentTaskHandle();
+    }
+
+    bool try_claim_bus(const esp_lcd_panel_t* panel) {
+        Bus& bus = panel_cast(panel)->bus;
+
+        if (bus.claimed.exchange(true)) {
+            return false;
+        }
+
+        bus.owner = xTaskGetCurrentTaskHandle();
+        return true;
+    }
+
+    constexpr int64_t no_deadline = INT64_MAX;
+
+    TickType_t ticks_until(const int64_t deadline_us) {
+        if (deadline_us == no_deadline) {
+            return portMAX_DELAY;
+        }
+
+        const int64_t remaining_us = std::max<int64_t>(deadline_us - esp_timer_get_time(), 0);
+        return pdMS_TO_TICKS((remaining_us + 999) / 1000); // NOLINT(*-magic-numbers)
+    }
+
+    // Claim the bus, unless somebody else still has it at `deadline_us`. Blocks rather than spins, so an
+    // owner of lower priority on the same core gets to run and let go.
+    bool wait_for_bus(const esp_lcd_panel_t* panel, const int64_t deadline_us) {
+        Bus& bus = panel_cast(panel)->bus;
+
+        // The batch's owner has had the bus since it opened the batch
+        if (batching(panel)) {
+            return true;
+        }
+
+        while (!try_claim_bus(panel)) {
+            ++bus.waiters;
+
+            // The owner may have let go before it could see us waiting. A give left over from an earlier
+            // release only costs another look.
+            const bool claimed = try_claim_bus(panel);
+            const bool woken = claimed || xSemaphoreTake(bus.released, ticks_until(deadline_us)) == pdTRUE;
+            --bus.waiters;
+
+            if (claimed) {
+                return true;
+            }
+
+            if (!woken && esp_timer_get_time() >= deadline_us) {
+                return try_claim_bus(panel);
+            }
+        }
+
+        return true;
+    }
+
+    // Wait until nobody else has the bus, and send the latest fade step first
+    void claim_bus(const esp_lcd_panel_t* panel) {
+        wait_for_bus(panel, no_deadline);
+        apply_pending_brightness(panel);
+    }
+
+    // Send the commands other tasks queued for us. Nobody is waiting on their result, so failures are only logged.
+    void send_queued_commands(const esp_lcd_panel_t* panel) {
+        LCDCmd cmd;
+
+        while (panel_cast(panel)->bus.queue.pop(cmd)) {
+            if (const esp_err_t ret = send_now(panel, cmd); ret != ESP_OK) {
+                ESP_LOGE(TAG, "Queued command %#010x failed: %s", cmd.lcd_cmd, esp_err_to_name(ret));
+            }
+        }
+    }
+
+    // Let go of the bus without sending anything, waking a task waiting for it
+    void let_go_of_bus(const esp_lcd_panel_t* panel) {
+        Bus& bus = panel_cast(panel)->bus;
+
+        if (batching(panel)) {
+            return; // Kept until the batch is committed
+        }
+
+        bus.owner = nullptr;
+        bus.claimed = false;
+
+        if (bus.waiters) {
+            xSemaphoreGive(bus.released);
+        }
+    }
+
+    // Send what other tasks queued while we had the bus, and let go of it. A command queued just as we
+    // let go would otherwise wait for the next claim, so we take the bus back for it if nobody else has.
+    void release_bus(const esp_lcd_panel_t* panel) {
+        if (batching(panel)) {
+            return; // Kept until the batch is committed
+        }
+
+        do {
+            if (const esp_err_t ret = apply_pending_brightness(panel); ret != ESP_OK) {
+                ESP_LOGE(TAG, "Fade step failed: %s", esp_err_to_name(ret));
+            }
+
+            send_queued_commands(panel);
+            let_go_of_bus(panel);
+        } while (!panel_cast(panel)->bus.queue.empty() && try_claim_bus(panel));
+    }
+
+    // Send a command if the bus is free, or queue it for the owner. ESP_ERR_NOT_FINISHED if neither can be
+    // done without waiting, the bus being busy and the queue full: for callers that mustn't block.
+    esp_err_t try_submit_command(const esp_lcd_panel_t* panel, const LCDCmd& cmd) {
+        Bus& bus = panel_cast(panel)->bus;
+
+        if (try_claim_bus(panel)) {
+            send_queued_commands(panel); // Commands queued before ours go first
+
+            const esp_err_t ret = send_now(panel, cmd);
+            release_bus(panel);
+
+            return ret;
+        }
+
+        if (!bus.queue.push(cmd)) {
+            return ESP_ERR_NOT_FINISHED;
+        }
+
+        // The owner may have let go before seeing our command
+        if (try_claim_bus(panel)) {
+            release_bus(panel);
+        }
+
+        return ESP_OK;
+    }
+
+    // Send a command from a task that doesn't have the bus. If somebody else has it, queue the command for
+    // them to send when they are done, unless the queue is full, in which case we wait our turn.
+    esp_err_t submit_command(const esp_lcd_panel_t* panel, const LCDCmd& cmd) {
+        if (const esp_err_t ret = try_submit_command(panel, cmd); ret != ESP_ERR_NOT_FINISHED) {
+            return ret;
+        }
+
+        ESP_LOGD(TAG, "Command queue full, waiting for the bus");
+        wait_for_bus(panel, no_deadline);
+        send_queued_commands(panel);
+
+        const esp_err_t ret = send_now(panel, cmd);
+        release_bus(panel);
+
+        return ret;
+    }
+
+    esp_err_t send_command(const esp_lcd_panel_t* panel, const LCDCmd& cmd) {
+        // Refused before it is queued, so the caller sees the error
+        ESP_RETURN_ON_FALSE(cmd.valid(), ESP_ERR_INVALID_ARG, TAG, "command %#010x has too many parameters",
+                            cmd.lcd_cmd);
+
+        if (batching(panel)) {
+            return queue_command(panel_cast(panel)->commands, cmd);
+        }
+
+        if (owns_bus(panel)) {
+            return send_now(panel, cmd);
+        }
+
+        return submit_command(panel, cmd);
+    }
+
+    esp_err_t send_command(const esp_lcd_panel_t* panel, const uint8_t command_addr,
+                           const std::initializer_list<uint8_t> param = {}) {
+        const LCDCmd cmd(command_addr, param);
+        return send_command(panel, cmd);
+    }
+
+    esp_err_t send_commands(const esp_lcd_panel_t* panel, const std::span<const LCDCmd> cmds) {
+        for (const auto& cmd : cmds) {
+            ESP_RETURN_ON_ERROR((send_command(panel, cmd)), TAG, "send command failed"); // NOLINT
+        }
+
+        return ESP_OK;
+    }
+
+    void invalidate_window(const esp_lcd_panel_t* panel) {
+        panel_cast(panel)->window_valid = false;
+    }
+
+    // Program the controller's column and row address window, unless it is already set to `window`.
+    // NOLINTBEGIN(*-magic-numbers)
+    esp_err_t set_window(const esp_lcd_panel_t* panel, const AddressWindow& window) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        if (rm690b0->window_valid && rm690b0->window == window) {
+            return ESP_OK;
+        }
+
+        const std::array<LCDCmd, 2> cmds = {{
+            {
+                LCD_CMD_CASET,
+                {
+                    static_cast<uint8_t>(window.x_start >> 8 & 0xFF),
+                    static_cast<uint8_t>(window.x_start & 0xFF),
+                    static_cast<uint8_t>(window.x_end >> 8 & 0xFF),
+                    static_cast<uint8_t>(window.x_end & 0xFF)
+                }
+            },
+            {
+                LCD_CMD_RASET,
+                {
+                    static_cast<uint8_t>(window.y_start >> 8 & 0xFF),
+                    static_cast<uint8_t>(window.y_start & 0xFF),
+                    static_cast<uint8_t>(window.y_end >> 8 & 0xFF),
+                    static_cast<uint8_t>(window.y_end & 0xFF)
+                }
+            }
+        }};
+
+        // If either command fails, we no longer know what the controller's window is
+        rm690b0->window_valid = false;
+        ESP_RETURN_ON_ERROR(send_commands(panel, cmds), TAG, "CASET/RASET failed"); // NOLINT
+
+        rm690b0->window = window;
+        rm690b0->window_valid = true;
+
+        return ESP_OK;
+    }
+
+    // NOLINTEND(*-magic-numbers)
+
+    // NOLINTBEGIN(*-magic-numbers)
+    uint8_t get_pixel_format(const esp_lcd_panel_t* panel) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        if (rm690b0->grayscale && rm690b0->bits_per_pixel != 8) {
+            ESP_LOGE(TAG, "Grayscale is only supported with 8 bits per pixel");
+            return 0;
+        }
+
+        switch (rm690b0->bits_per_pixel) {
+        case 3:
+            return color_3_bits_per_pixel;
+
+        case 8:
+            return rm690b0->grayscale ? grayscale_8_bits_per_pixel : color_8_bits_per_pixel;
+
+        case 16:
+            return color_16_bits_per_pixel;
+
+        case 18:
+            return color_18_bits_per_pixel;
+
+        case 24:
+            return color_24_bits_per_pixel;
+
+        default:
+            return 0;
+        }
+    }
+
+    // NOLINTEND(*-magic-numbers)
+
+    // 0x80 option matching the color depth: RGB565 pixels are sent in native byte order, nothing else is swapped
+    LCDCmd pixel_format_option_cmd(const esp_lcd_panel_t* panel) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+        const bool swap = rm690b0->bits_per_pixel == 16 && rm690b0->backend->swap_rgb565; // NOLINT(*-magic-numbers)
+        return {lcd_cmd_interface_pixel_format_option, {swap ? swap_rgb565_bytes : uint8_t{0}}};
+    }
+
+    // Returns the controller's code for the rotation set up by the user.
+    // Note that not all combinations seem to be supported by the RM690B0.
+    // For those, we return the nearest code known to work, and software_flip() makes up the difference.
+
+    // 0x60 = 0b01100000 swap xy + mirror y (rotate 90)
+    // 0x50 = 0b01010000 display goes wonky
+    // 0x40 = 0b01000000 display goes wonky
+    // 0x30 = 0b00110000 swap xy + mirror x (rotate -90)
+    // 0x20 = 0b00100000 swap xy
+    // 0x10 = 0b00010000 mirror y
+    // 0x00 = 0b00000000 default
+    uint8_t get_scan_direction(const esp_lcd_panel_t* panel) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        uint8_t rotation = rotation_normal;
+
+        if (rm690b0->swap_xy) {
+            if (rm690b0->mirror_x) {
+                rotation = rotation_minus90;
+            } else if (rm690b0->mirror_y) {
+                rotation = rotation_plus90;
+            } else {
+                rotation = rotation_swap_xy;
+            }
+        } else if (rm690b0->mirror_y) {
+            rotation = rotation_mirror_y;
+        }
+
+        return rotation;
+    }
+
+    struct Flip {
+        bool x;
+        bool y;
+
+        [[nodiscard]] bool any() const { return x || y; }
+    };
+
+    // The mirroring get_scan_direction() leaves out: mirror_x without swap_xy, and mirror_y on top of
+    // swap_xy and mirror_x. Without the panel size there is nothing to mirror against, so nothing.
+    Flip software_flip(const esp_lcd_panel_t* panel) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        if (!rm690b0->width || !rm690b0->height) {
+            return {};
+        }
+
+        if (!rm690b0->swap_xy) {
+            return {rm690b0->mirror_x, false};
+        }
+
+        return {false, rm690b0->mirror_x && rm690b0->mirror_y};
+    }
+
+    // Where `rect` ends up once software_flip() has mirrored it
+    Rect flip_rect(const esp_lcd_panel_t* panel, const Rect& rect, const Flip& flip) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+        const int width = rm690b0->swap_xy ? rm690b0->height : rm690b0->width;
+        const int height = rm690b0->swap_xy ? rm690b0->width : rm690b0->height;
+
+        return {
+            flip.x ? width - rect.x_end : rect.x_start,
+            flip.y ? height - rect.y_end : rect.y_start,
+            flip.x ? width - rect.x_start : rect.x_end,
+            flip.y ? height - rect.y_start : rect.y_end,
+        };
+    }
+
+    LCDCmd orientation_cmd(const esp_lcd_panel_t* panel) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        uint8_t param = get_scan_direction(panel);
+        const uint8_t element_order = rm690b0->rgb_ele_order == LCD_RGB_ELEMENT_ORDER_RGB
+                                          ? rbg_element_order_rgb
+                                          : rbg_element_order_bgr;
+        param |= element_order;
+        ESP_LOGD(TAG, "Applying rotation code: 0x%x", param); // NOLINT
+
+        return {LCD_CMD_MADCTL, {param}};
+    }
+
+    esp_err_t update_screen_orientation(const esp_lcd_panel_t* panel) {
+        return send_command(panel, orientation_cmd(panel));
+    }
+
+    // The controller scrolls along its frame memory lines: the panel's y axis, or x with swapped axes.
+    // Lines run the other way if the scan direction reverses them.
+    bool scroll_lines_reversed(const esp_lcd_panel_t* panel) {
+        return get_scan_direction(panel) & scan_reverse_lines;
+    }
+
+    // NOLINTBEGIN(*-magic-numbers)
+    LCDCmd scroll_area_cmd(const esp_lcd_panel_t* panel) {
+        const Scrolling& scrolling = panel_cast(panel)->scrolling;
+        const bool reversed = scroll_lines_reversed(panel);
+
+        const uint16_t top = reversed ? scrolling.bottom_fixed : scrolling.top_fixed;
+        const uint16_t bottom = reversed ? scrolling.top_fixed : scrolling.bottom_fixed;
+
+        return {
+            LCD_CMD_VSCRDEF,
+            {
+                static_cast<uint8_t>(top >> 8), static_cast<uint8_t>(top & 0xFF),
+                static_cast<uint8_t>(scrolling.lines >> 8), static_cast<uint8_t>(scrolling.lines & 0xFF),
+                static_cast<uint8_t>(bottom >> 8), static_cast<uint8_t>(bottom & 0xFF),
+            },
+        };
+    }
+
+    // Content moving towards lower panel coordinates moves towards higher controller lines if they are reversed
+    LCDCmd scroll_start_cmd(const esp_lcd_panel_t* panel) {
+        const Scrolling& scrolling = panel_cast(panel)->scrolling;
+        const bool reversed = scroll_lines_reversed(panel);
+
+        const uint16_t top = reversed ? scrolling.bottom_fixed : scrolling.top_fixed;
+        const uint16_t offset = reversed ? (scrolling.lines - scrolling.offset) % scrolling.lines : scrolling.offset;
+        const auto start = static_cast<uint16_t>(top + offset);
+
+        return {LCD_CMD_VSCSAD, {static_cast<uint8_t>(start >> 8), static_cast<uint8_t>(start & 0xFF)}};
+    }
+
+    // NOLINTEND(*-magic-numbers)
+
+    // Re-send the scroll area after a change of scan direction, which may have reversed the lines
+    esp_err_t update_scrolling(const esp_lcd_panel_t* panel) {
+        if (!panel_cast(panel)->scrolling.defined) {
+            return ESP_OK;
+        }
+
+        ESP_RETURN_ON_ERROR(send_command(panel, scroll_area_cmd(panel)), TAG, "VSCRDEF failed"); // NOLINT
+        return send_command(panel, scroll_start_cmd(panel));
+    }
+
+    // Scroll back and forget the scroll area, e.g. because it was along the other axis
+    esp_err_t stop_scrolling(const esp_lcd_panel_t* panel) {
+        Scrolling& scrolling = panel_cast(panel)->scrolling;
+
+        if (!scrolling.defined) {
+            return ESP_OK;
+        }
+
+        scrolling.offset = 0;
+        ESP_RETURN_ON_ERROR(send_command(panel, scroll_start_cmd(panel)), TAG, "VSCSAD failed"); // NOLINT
+        scrolling.defined = false;
+
+        return ESP_OK;
+    }
+
+    esp_err_t run_step(const esp_lcd_panel_t* panel, const SequenceStep& step) {
+        if (const auto* pin_step = std::get_if<PinStep>(&step)) {
+            return gpio_set_level(pin_step->pin, pin_step->level);
+        }
+
+        if (const auto* user_cmd = std::get_if<UserCmd>(&step)) {
+            return transmit(panel, *user_cmd->cmd);
+        }
+
+        return transmit(panel, std::get<LCDCmd>(step));
+    }
+
+    // Check a sequence can run, and update what it will change: a hardware reset turns scrolling, partial
+    // mode and idle mode off, and init sets the brightness to full.
+    esp_err_t prepare_sequence(const esp_lcd_panel_t* panel, const SequencePlan& plan) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        if (plan.init && !get_pixel_format(panel)) {
+            ESP_LOGE(TAG, "Unsupported pixel format setting: %d bits per pixel, grayscale: %d",
+                     rm690b0->bits_per_pixel,
+                     rm690b0->grayscale);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if (plan.reset && rm690b0->reset_gpio_num != GPIO_NUM_NC) {
+            rm690b0->scrolling = {};
+            rm690b0->partial = {};
+            rm690b0->idle = false;
+        }
+
+        if (plan.init) {
+            rm690b0->brightness = 0xFF; // NOLINT(*-magic-numbers)
+        }
+
+        return ESP_OK;
+    }
+
+    // Step `index` of a sequence, or nothing past its end. Each part of the plan is skipped over in turn.
+    std::optional<SequenceStep> sequence_step(const esp_lcd_panel_t* panel, const SequencePlan& plan, size_t index) {
+        using namespace std::literals;
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        if (plan.reset && rm690b0->reset_gpio_num != GPIO_NUM_NC) {
+            static constexpr auto delay = 300ms;
+            static constexpr std::array<uint32_t, 3> levels = {HIGH, LOW, HIGH};
+
+            if (index < levels.size()) {
+                return PinStep{rm690b0->reset_gpio_num, levels.at(index), delay};
+            }
+
+            index -= levels.size();
+        }
+
+        if (plan.init) {
+            // Power up the AMOLED controller
+            if (rm690b0->en_gpio_num != GPIO_NUM_NC) {
+                // The RM690B0 controller needs time to wake up before it can process commands
+                if (index == 0) {
+                    return PinStep{rm690b0->en_gpio_num, HIGH, 25ms};
+                }
+
+                --index;
+            }
+
+            // Initialization commands, the user's or ours
+            if (rm690b0->init_cmds.empty()) {
+                if (index < default_init_cmds.size()) {
+                    return default_init_cmds.at(index);
+                }
+
+                index -= default_init_cmds.size();
+            } else {
+                if (index < rm690b0->init_cmds.size()) {
+                    const rm690b0_lcd_init_cmd_t& cmd = rm690b0->init_cmds[index];
+                    return UserCmd{&cmd, std::chrono::milliseconds(cmd.delay_ms)};
+                }
+
+                index -= rm690b0->init_cmds.size();
+            }
+
+            // Set up the image
+            const bool format_option = rm690b0->bits_per_pixel == 16; // NOLINT(*-magic-numbers)
+            const std::array<std::optional<LCDCmd>, 4> image_cmds = {
+                orientation_cmd(panel),
+                LCDCmd{LCD_CMD_COLMOD, {get_pixel_format(panel)}},
+                format_option ? std::optional(pixel_format_option_cmd(panel)) : std::nullopt,
+                LCDCmd{lcd_cmd_write_display_brightness, {0xFF}}, // NOLINT(*-magic-numbers)
+            };
+
+            for (const auto& cmd : image_cmds) {
+                if (cmd && index-- == 0) {
+                    return *cmd;
+                }
+            }
+        }
+
+        if (plan.command && index == 0) {
+            return LCDCmd{*plan.command, {}};
+        }
+
+        return std::nullopt;
+    }
+
+    esp_err_t run_steps(const esp_lcd_panel_t* panel, const SequencePlan& plan) {
+        ESP_RETURN_ON_ERROR(prepare_sequence(panel, plan), TAG, "Failed to prepare sequence"); // NOLINT
+
+        for (size_t index = 0; const auto step = sequence_step(panel, plan, index); ++index) {
+            ESP_RETURN_ON_ERROR(run_step(panel, *step), TAG, "sequence step failed"); // NOLINT
+
+            if (const auto delay = step_delay(*step); delay.count() > 0) {
+                std::this_thread::sleep_for(delay);
+            }
+        }
+
+        return ESP_OK;
+    }
+
+    bool sequence_running(const esp_lcd_panel_t* panel) {
+        return panel_cast(panel)->sequence.busy;
+    }
+
+    void record_init_time(const esp_lcd_panel_t* panel, const int64_t time_us) {
+        Stats& stats = panel_cast(panel)->stats;
+
+        portENTER_CRITICAL(&stats.lock);
+        stats.totals.init_time_us = static_cast<uint32_t>(time_us);
+        portEXIT_CRITICAL(&stats.lock);
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    esp_err_t init(esp_lcd_panel_t* panel) {
+        ESP_RETURN_ON_FALSE(!sequence_running(panel), ESP_ERR_INVALID_STATE, TAG, "async sequence in progress");
+        invalidate_window(panel);
+
+        const int64_t start = esp_timer_get_time();
+
+        ESP_RETURN_ON_ERROR(run_steps(panel, {.reset = false, .init = true, .command = std::nullopt}), TAG, // NOLINT
+                            "Failed to send init commands to display");
+
+        record_init_time(panel, esp_timer_get_time() - start);
+        return ESP_OK;
+    }
+
+    // Read a one-byte register
+    esp_err_t read_register(const esp_lcd_panel_t* panel, const uint8_t command_addr, uint8_t& value) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+        const int lcd_cmd = bus_command(panel, read_prefix + (static_cast<int32_t>(command_addr) << 8));
+
+        return rm690b0->io->rx_param(rm690b0->io, lcd_cmd, &value, 1);
+    }
+
+    // Bring up a panel that kept power, e.g. across deep sleep, without reset and init. Only the
+    // settings that differ from ours are sent. Sets `warm` to false, and leaves the panel untouched,
+    // if the panel isn't running.
+    esp_err_t warm_start(const esp_lcd_panel_t* panel, bool& warm) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        warm = false;
+
+        ESP_RETURN_ON_FALSE(rm690b0->io->rx_param, ESP_ERR_NOT_SUPPORTED, TAG, "panel IO can't read registers");
+
+        // Make sure we don't hold the panel in reset or power it off. If it wasn't powered, it won't answer.
+        for (const gpio_num_t pin : {rm690b0->reset_gpio_num, rm690b0->en_gpio_num}) {
+            if (pin != GPIO_NUM_NC) {
+                ESP_RETURN_ON_ERROR(gpio_set_level(pin, HIGH), TAG, "Failed to set pin"); // NOLINT
+            }
+        }
+
+        uint8_t power_mode = 0;
+        if (read_register(panel, lcd_cmd_read_power_mode, power_mode) != ESP_OK ||
+            (power_mode & (power_mode_sleep_out | power_mode_display_on)) !=
+            (power_mode_sleep_out | power_mode_display_on)) {
+            ESP_LOGD(TAG, "Panel isn't running (power mode 0x%x), warm start not possible", power_mode);
+            return ESP_OK;
+        }
+
+        rm690b0->power.asleep = false;
+        rm690b0->power.display_on = true;
+
+        uint8_t madctl = 0;
+        uint8_t colmod = 0;
+        uint8_t brightness = 0;
+        ESP_RETURN_ON_ERROR(read_register(panel, lcd_cmd_read_madctl, madctl), TAG, "RDDMADCTL failed"); // NOLINT
+        ESP_RETURN_ON_ERROR(read_register(panel, lcd_cmd_read_colmod, colmod), TAG, "RDDCOLMOD failed"); // NOLINT
+        ESP_RETURN_ON_ERROR(read_register(panel, lcd_cmd_read_display_brightness, brightness), TAG, // NOLINT
+                            "RDDISBV failed");
+
+        if (const LCDCmd orientation = orientation_cmd(panel); madctl != orientation.param.at(0)) {
+            ESP_LOGD(TAG, "MADCTL is 0x%x, updating", madctl);
+            ESP_RETURN_ON_ERROR(transmit(panel, orientation), TAG, "MADCTL failed"); // NOLINT
+        }
+
+        if (const uint8_t pixel_format = get_pixel_format(panel); colmod != pixel_format) {
+            ESP_LOGD(TAG, "COLMOD is 0x%x, updating", colmod);
+            ESP_RETURN_ON_FALSE(pixel_format, ESP_ERR_INVALID_ARG, TAG, "unsupported pixel format");
+            ESP_RETURN_ON_ERROR(transmit(panel, LCDCmd{LCD_CMD_COLMOD, {pixel_format}}), TAG, // NOLINT
+                                "COLMOD failed");
+        }
+
+        // There is no reading back the pixel format option, but it's cheap to send
+        if (rm690b0->bits_per_pixel == 16) { // NOLINT(*-magic-numbers)
+            ESP_RETURN_ON_ERROR(transmit(panel, pixel_format_option_cmd(panel)), TAG, "0x80 option failed"); // NOLINT
+        }
+
+        rm690b0->brightness = brightness;
+        warm = true;
+
+        return ESP_OK;
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    esp_err_t reset(esp_lcd_panel_t* panel) {
+        ESP_RETURN_ON_FALSE(!sequence_running(panel), ESP_ERR_INVALID_STATE, TAG, "async sequence in progress");
+        invalidate_window(panel);
+
+        return run_steps(panel, {.reset = true, .init = false, .command = std::nullopt});
+    }
+
+    void finish_async_sequence(RM690B0Panel* rm690b0, const esp_err_t result) {
+        AsyncSequence& seq = rm690b0->sequence;
+
+        const esp_lcd_panel_rm690b0_done_cb_t done_cb = seq.done_cb;
+        void* user_ctx = seq.user_ctx;
+
+        if (result == ESP_OK && seq.init) {
+            record_init_time(&rm690b0->base, esp_timer_get_time() - seq.start_us);
+        }
+
+        seq.busy = false;
+
+        if (result != ESP_OK) {
+            ESP_LOGE(TAG, "Async sequence failed at step %zu: %s", seq.next_step, esp_err_to_name(result));
+        }
+
+        if (done_cb) {
+            done_cb(&rm690b0->base, result, user_ctx);
+        }
+    }
+
+    // esp_timer callback. Runs steps until one of them needs a delay, then re-arms the timer for that delay.
+    void run_async_sequence(void* arg) {
+        auto* rm690b0 = static_cast<RM690B0Panel*>(arg);
+        AsyncSequence& seq = rm690b0->sequence;
+
+        while (const auto step = sequence_step(&rm690b0->base, seq.plan, seq.next_step)) {
+            ++seq.next_step;
+
+            esp_err_t ret = run_step(&rm690b0->base, *step);
+            if (ret != ESP_OK) {
+                finish_async_sequence(rm690b0, ret);
+                return;
+            }
+
+            if (const auto delay = step_delay(*step); delay.count() > 0) {
+                const auto delay_us = std::chrono::duration_cast<std::chrono::microseconds>(delay);
+                ret = esp_timer_start_once(seq.timer, delay_us.count());
+                if (ret != ESP_OK) {
+                    finish_async_sequence(rm690b0, ret);
+                }
+
+                return;
+            }
+        }
+
+        finish_async_sequence(rm690b0, ESP_OK);
+    }
+
+    esp_err_t start_async_sequence(const esp_lcd_panel_t* panel, const SequencePlan& plan,
+                                   const esp_lcd_panel_rm690b0_done_cb_t done_cb, void* user_ctx) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        AsyncSequence& seq = rm690b0->sequence;
+
+        bool expected = false;
+        ESP_RETURN_ON_FALSE(seq.busy.compare_exchange_strong(expected, true), ESP_ERR_INVALID_STATE, TAG,
+                            "async sequence already in progress");
+
+        esp_err_t ret = prepare_sequence(panel, plan);
+        if (ret == ESP_OK && !seq.timer) {
+            const esp_timer_create_args_t timer_args = {
+                .callback = run_async_sequence,
+                .arg = rm690b0,
+                .dispatch_method = ESP_TIMER_TASK,
+                .name = "rm690b0_seq",
+                .skip_unhandled_events = false,
+            };
+
+            ret = esp_timer_create(&timer_args, &seq.timer);
+        }
+
+        if (ret == ESP_OK) {
+            seq.plan = plan;
+            seq.next_step = 0;
+            seq.done_cb = done_cb;
+            seq.user_ctx = user_ctx;
+            seq.init = plan.init;
+            seq.start_us = esp_timer_get_time();
+
+            ret = esp_timer_start_once(seq.timer, 0);
+        }
+
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to start async sequence: %s", esp_err_to_name(ret));
+            seq.busy = false;
+        }
+
+        return ret;
+    }
+
+    // Bits each pixel takes on the wire. 18-bit pixels are sent as 3 bytes, with each component in the top 6 bits.
+    uint8_t wire_bits_per_pixel(const uint8_t bits_per_pixel) {
+        return bits_per_pixel == 18 ? 24 : bits_per_pixel; // NOLINT(*-magic-numbers)
+    }
+
+    size_t color_bytes(const esp_lcd_panel_t* panel, const size_t pixels) {
+        static constexpr uint8_t bits_per_byte = 8;
+        return pixels * wire_bits_per_pixel(panel_cast(panel)->bits_per_pixel) / bits_per_byte;
+    }
+
+    // Bytes per pixel in a framebuffer, or 0 if pixels don't fill whole bytes
+    size_t bytes_per_pixel(const esp_lcd_panel_t* panel) {
+        static constexpr uint8_t bits_per_byte = 8;
+        const uint8_t bits_per_pixel = wire_bits_per_pixel(panel_cast(panel)->bits_per_pixel);
+
+        return bits_per_pixel % bits_per_byte ? 0 : bits_per_pixel / bits_per_byte;
+    }
+
+    // Account for a finished flush. Called from the ISR, or from the drawing task if we don't see transfers finish.
+    void IRAM_ATTR record_latency(Stats& stats, const int64_t latency_us, const uint32_t bytes) {
+        const auto latency = static_cast<uint32_t>(latency_us);
+        rm690b0_stats_t& totals = stats.totals;
+
+        portENTER_CRITICAL_SAFE(&stats.lock);
+        // No std::min/max, they might not be inlined into IRAM
+        if (!totals.flush_count || latency < totals.latency_min_us) {
+            totals.latency_min_us = latency;
+        }
+
+        if (latency > totals.latency_max_us) {
+            totals.latency_max_us = latency;
+        }
+
+        ++totals.flush_count;
+        stats.latency_total_us += latency;
+        stats.latency_bytes += bytes;
+        portEXIT_CRITICAL_SAFE(&stats.lock);
+    }
+
+    bool IRAM_ATTR on_color_trans_done(esp_lcd_panel_io_handle_t, esp_lcd_panel_io_event_data_t*, void* user_ctx) {
+        auto* rm690b0 = static_cast<RM690B0Panel*>(user_ctx);
+        ColorTransfers& transfers = rm690b0->transfers;
+
+        const uint32_t completed = transfers.completed.fetch_add(1) + 1;
+        const uint32_t index = (completed - 1) % ColorTransfers::max_in_flight;
+        const uint8_t tag = transfers.tags[index];
+        const uint32_t bytes = transfers.sizes[index];
+        const uint32_t completed_bytes = transfers.completed_bytes.fetch_add(bytes) + bytes;
+
+        BaseType_t need_yield = pdFALSE;
+
+        if (transfers.drained && completed == transfers.submitted) {
+            xSemaphoreGiveFromISR(transfers.drained, &need_yield);
+        }
+
+        if (transfers.cbs.on_transfer_done &&
+            transfers.cbs.on_transfer_done(&rm690b0->base, bytes, transfers.submitted_bytes - completed_bytes,
+                                           transfers.user_ctx)) {
+            need_yield = pdTRUE;
+        }
+
+        if (tag & transfer_band_buffer) {
+            xSemaphoreGiveFromISR(rm690b0->streaming.free_buffers, &need_yield);
+        }
+
+        if (tag & transfer_pm_lock) {
+            esp_pm_lock_release(rm690b0->power.pm_lock);
+        }
+
+        if (tag & transfer_fill && rm690b0->fill.in_flight.fetch_sub(1) == 1) {
+            xSemaphoreGiveFromISR(rm690b0->fill.idle, &need_yield);
+        }
+
+        if (tag & transfer_end_of_draw) {
+            record_latency(rm690b0->stats, esp_timer_get_time() - transfers.flush_start_us[index],
+                           transfers.flush_bytes[index]);
+        }
+
+        if (tag & transfer_end_of_draw && transfers.cbs.on_color_trans_done &&
+            transfers.cbs.on_color_trans_done(&rm690b0->base, transfers.user_ctx)) {
+            need_yield = pdTRUE;
+        }
+
+        if (const Pipeline& pipeline = rm690b0->pipeline; transfers.flush_buffers[index] && pipeline.done_cb &&
+            pipeline.done_cb(&rm690b0->base, transfers.flush_buffers[index], pipeline.user_ctx)) {
+            need_yield = pdTRUE;
+        }
+
+        return need_yield == pdTRUE;
+    }
+
+    // Route the panel IO's transfer-done events through this driver. Needed whenever the driver has
+    // to know when a transfer has finished, e.g. to reuse a streaming buffer.
+    esp_err_t claim_io_callbacks(const esp_lcd_panel_t* panel) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        if (rm690b0->transfers.io_callbacks_claimed) {
+            return ESP_OK;
+        }
+
+        const esp_lcd_panel_io_callbacks_t cbs = {
+            .on_color_trans_done = on_color_trans_done,
+        };
+
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_io_register_event_callbacks(rm690b0->io, &cbs, rm690b0), TAG, // NOLINT
+                            "Failed to register panel IO callbacks");
+
+        rm690b0->transfers.io_callbacks_claimed = true;
+        return ESP_OK;
+    }
+
+    esp_err_t submit_color(const esp_lcd_panel_t* panel, const int lcd_cmd, const void* color, const size_t size,
+                           const uint8_t tag) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        ColorTransfers& transfers = rm690b0->transfers;
+        const esp_lcd_panel_io_handle_t io = rm690b0->io; // NOLINT(*-misplaced-const)
+
+        Stats& stats = rm690b0->stats;
+        stats.flush_pixel_bytes += size;
+
+        const int bus_cmd = bus_command(panel, lcd_cmd);
+
+        if (!transfers.io_callbacks_claimed) {
+            return io->tx_color(io, bus_cmd, color, size);
+        }
+
+        // Keep the bus clock up until this transfer is done
+        const Power& power = rm690b0->power;
+        const bool pm_locked = power.use_pm_lock && power.pm_lock && esp_pm_lock_acquire(power.pm_lock) == ESP_OK;
+
+        // The tag must be in place before the transfer can possibly complete
+        const size_t index = transfers.submitted % ColorTransfers::max_in_flight;
+        transfers.tags[index] = tag | (pm_locked ? transfer_pm_lock : 0);
+        transfers.flush_start_us[index] = stats.flush_start_us;
+        transfers.flush_bytes[index] = stats.flush_pixel_bytes;
+        transfers.flush_buffers[index] = tag & transfer_end_of_draw ? transfers.flush_buffer : nullptr;
+        transfers.sizes[index] = size;
+        transfers.submitted_bytes += size;
+        ++transfers.submitted;
+
+        const esp_err_t ret = io->tx_color(io, bus_cmd, color, size);
+        if (ret != ESP_OK) {
+            --transfers.submitted;
+            transfers.submitted_bytes -= size;
+            stats.flush_pixel_bytes -= size;
+
+            if (pm_locked) {
+                esp_pm_lock_release(power.pm_lock);
+            }
+
+            // The ISR may have seen the last transfer before this one finish while this one still counted
+            if (transfers.drained && transfers.completed == transfers.submitted) {
+                xSemaphoreGive(transfers.drained);
+            }
+        }
+
+        return ret;
+    }
+
+    // Send pixels through the streaming buffers: RAMWR for the first band, RAMWRC for the rest.
+    // Bands are gathered from the source row by row, and can end mid-row, since RAMWRC simply continues
+    // where the previous write stopped.
+    template <typename Source>
+    esp_err_t stream_bands(const esp_lcd_panel_t* panel, const Source& source, const uint8_t end_tag) {
+        const TraceScope trace(trace_color);
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        Streaming& streaming = rm690b0->streaming;
+
+        // Keep bands to whole pixels, whatever the pixel size
+        const uint8_t bits_per_pixel = wire_bits_per_pixel(rm690b0->bits_per_pixel);
+        const size_t band_size = streaming.buffer_size / bits_per_pixel * bits_per_pixel;
+        const size_t size = source.size();
+
+        size_t row = 0;
+        size_t row_offset = 0;
+
+        for (size_t offset = 0; offset < size;) {
+            // Wait until the transfer that last used this buffer is done
+            xSemaphoreTake(streaming.free_buffers, portMAX_DELAY);
+
+            uint8_t* buffer = streaming.buffers.at(streaming.next_buffer).get();
+            streaming.next_buffer ^= 1;
+
+            size_t length = 0;
+            while (length < band_size && row < source.rows) {
+                const size_t chunk = std::min(band_size - length, source.row_bytes - row_offset);
+                source.copy(row, row_offset, buffer + length, chunk);
+
+                length += chunk;
+                row_offset += chunk;
+                if (row_offset == source.row_bytes) {
+                    ++row;
+                    row_offset = 0;
+                }
+            }
+
+            const int lcd_cmd = pixel_prefix + ((offset == 0 ? LCD_CMD_RAMWR : LCD_CMD_RAMWRC) << 8);
+            offset += length;
+            const uint8_t tag = transfer_band_buffer | (offset == size ? end_tag : 0);
+
+            const esp_err_t ret = submit_color(panel, lcd_cmd, buffer, length, tag);
+            if (ret != ESP_OK) {
+                xSemaphoreGive(streaming.free_buffers);
+                ESP_LOGE(TAG, "Failed to send band ending at offset %zu: %s", offset, esp_err_to_name(ret));
+                return ret;
+            }
+        }
+
+        return ESP_OK;
+    }
+
+    // Stream `source` into the window begin_window() just set, mirrored as software_flip() says
+    template <typename Source>
+    esp_err_t stream_pixels(const esp_lcd_panel_t* panel, const Source& source, const uint8_t end_tag) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        const Flip flip = software_flip(panel);
+        if (!flip.any()) {
+            return stream_bands(panel, source, end_tag);
+        }
+
+        const AddressWindow& window = rm690b0->window;
+        const size_t pixel_size = bytes_per_pixel(panel);
+        const FlippedSource<Source> flipped = {
+            .source = source,
+            .row_bytes = (window.x_end - window.x_start + 1) * pixel_size,
+            .rows = static_cast<size_t>(window.y_end - window.y_start + 1),
+            .pixel_size = pixel_size,
+            .flip_x = flip.x,
+            .flip_y = flip.y,
+        };
+
+        return stream_bands(panel, flipped, end_tag);
+    }
+
+    // Send pixels straight from the source, one transfer per row unless the rows are contiguous
+    esp_err_t send_pixels(const esp_lcd_panel_t* panel, const PixelSource& source, const uint8_t end_tag) {
+        // Mirrored pixels have to be rearranged on the way
+        if (software_flip(panel).any()) {
+            ESP_RETURN_ON_FALSE(panel_cast(panel)->streaming.buffer_size, ESP_ERR_NOT_SUPPORTED, TAG,
+                                "this orientation needs stream buffers");
+            return stream_pixels(panel, source, end_tag);
+        }
+
+        const TraceScope trace(trace_color);
+
+        if (source.contiguous()) {
+            constexpr int lcd_cmd = pixel_prefix + (LCD_CMD_RAMWR << 8);
+            return submit_color(panel, lcd_cmd, source.data, source.size(), end_tag);
+        }
+
+        for (size_t row = 0; row < source.rows; ++row) {
+            const int lcd_cmd = pixel_prefix + ((row == 0 ? LCD_CMD_RAMWR : LCD_CMD_RAMWRC) << 8);
+            const uint8_t tag = row + 1 == source.rows ? end_tag : 0;
+
+            ESP_RETURN_ON_ERROR(submit_color(panel, lcd_cmd, source.data + row * source.stride, // NOLINT
+                                             source.row_bytes, tag), TAG, "Failed to send row %zu", row);
+        }
+
+        return ESP_OK;
+    }
+
+    esp_err_t init_streaming(const esp_lcd_panel_t* panel, const size_t buffer_size) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        Streaming& streaming = rm690b0->streaming;
+
+        if (buffer_size == 0) {
+            return ESP_OK;
+        }
+
+        // Big enough for any color depth the panel can be switched to
+        ESP_RETURN_ON_FALSE(buffer_size >= max_wire_bits_per_pixel, ESP_ERR_INVALID_ARG, TAG,
+                            "stream buffer must hold at least 8 pixels");
+
+        for (auto& buffer : streaming.buffers) {
+            buffer.reset(static_cast<uint8_t*>(heap_caps_malloc(buffer_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL)));
+            ESP_RETURN_ON_FALSE(buffer, ESP_ERR_NO_MEM, TAG, "no memory for stream buffers");
+        }
+
+        streaming.free_buffers = xSemaphoreCreateCounting(streaming.buffers.size(), streaming.buffers.size());
+        ESP_RETURN_ON_FALSE(streaming.free_buffers, ESP_ERR_NO_MEM, TAG, "no memory for stream semaphore");
+
+        ESP_RETURN_ON_ERROR(claim_io_callbacks(panel), TAG, "Failed to claim panel IO callbacks"); // NOLINT
+
+        streaming.buffer_size = buffer_size;
+        ESP_LOGD(TAG, "Streaming through 2 x %zu byte buffers", buffer_size);
+
+        return ESP_OK;
+    }
+
+    // Rising edge of the TE output, i.e. the start of the controller's vertical blanking period
+    void IRAM_ATTR te_isr_handler(void* arg) {
+        auto* rm690b0 = static_cast<RM690B0Panel*>(arg);
+        TearingEffect& te = rm690b0->te;
+        const int64_t now = esp_timer_get_time();
+
+        portENTER_CRITICAL_ISR(&te.lock);
+        if (te.edge_count > 0) {
+            // Smooth the period so a single late interrupt doesn't throw it off
+            const auto delta = static_cast<uint32_t>(now - te.last_edge_us);
+            te.period_us = te.period_us ? (te.period_us * 7 + delta) / 8 : delta; // NOLINT(*-magic-numbers)
+        }
+
+        te.last_edge_us = now;
+        ++te.edge_count;
+        const esp_lcd_panel_rm690b0_vsync_cb_t vsync_cb = te.vsync_cb;
+        void* vsync_ctx = te.vsync_ctx;
+        portEXIT_CRITICAL_ISR(&te.lock);
+
+        BaseType_t need_yield = pdFALSE;
+        xSemaphoreGiveFromISR(te.edge, &need_yield);
+
+        if (vsync_cb && vsync_cb(&rm690b0->base, now, vsync_ctx)) {
+            need_yield = pdTRUE;
+        }
+
+        if (need_yield) {
+            portYIELD_FROM_ISR();
+        }
+    }
+
+    // Block until the next TE edge, so the pixel stream starts right behind the controller's scan line.
+    // If the edge doesn't come within two frames, we log and carry on, since a late frame is better than none.
+    void wait_for_te(const esp_lcd_panel_t* panel) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        TearingEffect& te = rm690b0->te;
+
+        static constexpr uint32_t default_timeout_ms = 50;
+
+        portENTER_CRITICAL(&te.lock);
+        const uint32_t period_us = te.period_us;
+        portEXIT_CRITICAL(&te.lock);
+
+        const uint32_t timeout_ms = period_us ? 2 * period_us / 1000 + 1 : default_timeout_ms; // NOLINT(*-magic-numbers)
+
+        // Drop an edge that arrived before we started waiting
+        xSemaphoreTake(te.edge, 0);
+
+        if (xSemaphoreTake(te.edge, pdMS_TO_TICKS(timeout_ms) + 1) != pdTRUE) {
+            ESP_LOGW(TAG, "No TE pulse within %" PRIu32 " ms, drawing anyway", timeout_ms);
+        }
+    }
+
+    // The conversion format matching the panel's color depth. Returns false for depths that have none.
+    // NOLINTBEGIN(*-magic-numbers)
+    bool panel_pixel_format(const esp_lcd_panel_t* panel, rm690b0_pixel_format_t& format) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        switch (rm690b0->bits_per_pixel) {
+        case 8:
+            format = RM690B0_PIXEL_FORMAT_GRAY8;
+            return rm690b0->grayscale;
+
+        case 16:
+            format = RM690B0_PIXEL_FORMAT_RGB565;
+            return true;
+
+        case 18:
+            format = RM690B0_PIXEL_FORMAT_RGB666;
+            return true;
+
+        case 24:
+            format = RM690B0_PIXEL_FORMAT_RGB888;
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    // NOLINTEND(*-magic-numbers)
+
+    // Check the panel's (new) color depth works with everything set up for the old one, then send it
+    esp_err_t send_color_depth(const esp_lcd_panel_t* panel) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        const uint8_t pixel_format = get_pixel_format(panel);
+        ESP_RETURN_ON_FALSE(pixel_format, ESP_ERR_INVALID_ARG, TAG, "unsupported color depth: %d bits per pixel",
+                            rm690b0->bits_per_pixel);
+
+        rm690b0_pixel_format_t panel_format{};
+        ESP_RETURN_ON_FALSE(!rm690b0->convert || panel_pixel_format(panel, panel_format), ESP_ERR_NOT_SUPPORTED, TAG,
+                            "no conversion to %d bits per pixel", rm690b0->bits_per_pixel);
+        ESP_RETURN_ON_FALSE(!rm690b0->align.framebuffer || bytes_per_pixel(panel), ESP_ERR_NOT_SUPPORTED, TAG,
+                            "alignment needs a whole number of bytes per pixel");
+
+        ESP_RETURN_ON_ERROR(send_command(panel, LCDCmd{LCD_CMD_COLMOD, {pixel_format}}), TAG, // NOLINT
+                            "Failed to send COLMOD");
+        return send_command(panel, pixel_format_option_cmd(panel));
+    }
+
+    // Set up `rect` for drawing and send RAMWR, optionally waiting for TE first
+    esp_err_t begin_window(const esp_lcd_panel_t* panel, const AddressWindow& window, const bool wait_te) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        ESP_RETURN_ON_FALSE(!sequence_running(panel), ESP_ERR_INVALID_STATE, TAG, "async sequence in progress");
+        ESP_RETURN_ON_FALSE(!batching(panel), ESP_ERR_INVALID_STATE, TAG, "command batch open");
+
+        Stats& stats = rm690b0->stats;
+        const int64_t start = esp_timer_get_time();
+        int64_t te_wait_us = 0;
+        const TraceScope trace(trace_window);
+
+        esp_err_t ret = set_window(panel, window);
+
+        if (ret == ESP_OK && wait_te) {
+            const TraceScope te_trace(trace_te_wait);
+            const int64_t te_start = esp_timer_get_time();
+            wait_for_te(panel);
+            te_wait_us = esp_timer_get_time() - te_start;
+        }
+
+        if (ret == ESP_OK) {
+            ret = send_command(panel, LCD_CMD_RAMWR);
+        }
+
+        stats.flush_window_us += esp_timer_get_time() - start - te_wait_us;
+        stats.flush_te_wait_us += te_wait_us;
+
+        ESP_RETURN_ON_ERROR(ret, TAG, "window commands failed"); // NOLINT
+
+        return ESP_OK;
+    }
+
+    esp_err_t begin_window(const esp_lcd_panel_t* panel, const Rect& area, const bool wait_te) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+        const Rect rect = flip_rect(panel, area, software_flip(panel));
+
+        // Set the drawing window
+        //
+        // The -1 adjustment to x_end and y_end is needed because the esp_lcd API
+        // says the drawing windows *excludes* x_end and y_end, but the RM690B0 chip
+        // expects they are included.
+        const AddressWindow window = {
+            rect.x_start + rm690b0->x_gap,
+            rect.y_start + rm690b0->y_gap,
+            rect.x_end + rm690b0->x_gap - 1,
+            rect.y_end + rm690b0->y_gap - 1,
+        };
+
+        return begin_window(panel, window, wait_te);
+    }
+
+    // Draw `source` into `rect`, optionally waiting for TE first. `end_tag` is attached to the last transfer.
+    esp_err_t draw_window(const esp_lcd_panel_t* panel, const Rect& rect, const PixelSource& source,
+                          const bool wait_te, const uint8_t end_tag) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        ESP_RETURN_ON_ERROR(begin_window(panel, rect, wait_te), TAG, "Failed to set up window"); // NOLINT
+
+        // Send color data. Gather rows through the streaming buffers if we can, since sending
+        // them one by one costs a transaction per row.
+        if (rm690b0->streaming.buffer_size && (!esp_ptr_dma_capable(source.data) || !source.contiguous())) {
+            return stream_pixels(panel, source, end_tag);
+        }
+
+        return send_pixels(panel, source, end_tag);
+    }
+
+    // Grow `rect` (in panel coordinates) so that it is aligned in controller coordinates
+    Rect align_rect(const esp_lcd_panel_t* panel, const Rect& rect) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        auto round_down = [](const int value, const int gap, const int alignment) {
+            const int controller = value + gap;
+            return controller - controller % alignment - gap;
+        };
+
+        auto round_up = [](const int value, const int gap, const int alignment) {
+            const int controller = value + gap + alignment - 1;
+            return controller - controller % alignment - gap;
+        };
+
+        return {
+            round_down(rect.x_start, rm690b0->x_gap, column_alignment),
+            round_down(rect.y_start, rm690b0->y_gap, row_alignment),
+            round_up(rect.x_end, rm690b0->x_gap, column_alignment),
+            round_up(rect.y_end, rm690b0->y_gap, row_alignment),
+        };
+    }
+
+    // Brightness `fraction` of the way through the fade. The gamma curve ramps evenly in perceived
+    // lightness rather than in register steps, so fades don't seem to rush at the dark end.
+    uint8_t fade_level(const Fade& fade, const float fraction) {
+        static constexpr float gamma = 2.2F;
+        static constexpr float max_level = 255.0F;
+
+        if (fade.curve == RM690B0_FADE_GAMMA) {
+            const float from = std::pow(fade.from / max_level, 1 / gamma);
+            const float to = std::pow(fade.to / max_level, 1 / gamma);
+            return static_cast<uint8_t>(std::lround(std::pow(from + (to - from) * fraction, gamma) * max_level));
+        }
+
+        return static_cast<uint8_t>(std::lround(fade.from + (fade.to - fade.from) * fraction));
+    }
+
+    bool transfers_drained(const RM690B0Panel* rm690b0) {
+        return rm690b0->transfers.completed == rm690b0->transfers.submitted;
+    }
+
+    // Send the fade step from the esp_timer task, but only if that can't block it: the bus is free and no
+    // pixels are in flight, which a command would wait for. Otherwise a later step or the next draw sends it.
+    esp_err_t send_fade_step(RM690B0Panel* rm690b0) {
+        Fade& fade = rm690b0->fade;
+
+        if (!transfers_drained(rm690b0) || !try_claim_bus(&rm690b0->base)) {
+            return ESP_OK;
+        }
+
+        // Somebody may have drawn between our look and our claim. Then keep the step from release_bus.
+        esp_err_t ret = ESP_OK;
+        int deferred = -1;
+        if (transfers_drained(rm690b0)) {
+            ret = apply_pending_brightness(&rm690b0->base);
+        } else {
+            deferred = fade.pending.exchange(-1);
+        }
+
+        release_bus(&rm690b0->base);
+
+        if (deferred >= 0) {
+            int none = -1;
+            fade.pending.compare_exchange_strong(none, deferred);
+        }
+
+        return ret;
+    }
+
+    // esp_timer callback for one fade step
+    void run_fade(void* arg) { // NOLINT(*-non-const-parameter)
+        auto* rm690b0 = static_cast<RM690B0Panel*>(arg);
+        Fade& fade = rm690b0->fade;
+
+        xSemaphoreTake(fade.lock, portMAX_DELAY);
+
+        // Cancelled after this step came due
+        if (!fade.active) {
+            xSemaphoreGive(fade.lock);
+            return;
+        }
+
+        const int64_t elapsed = esp_timer_get_time() - fade.start_us;
+        const float fraction = fade.duration_us && elapsed < fade.duration_us
+                                   ? static_cast<float>(elapsed) / static_cast<float>(fade.duration_us)
+                                   : 1.0F;
+
+        fade.pending = fade_level(fade, fraction);
+        const esp_err_t ret = send_fade_step(rm690b0);
+
+        // Finished once the last step has been sent, by us or by a draw
+        if (ret == ESP_OK && (fraction < 1.0F || fade.pending >= 0)) {
+            xSemaphoreGive(fade.lock);
+            return;
+        }
+
+        esp_timer_stop(fade.timer);
+        fade.active = false;
+
+        const esp_lcd_panel_rm690b0_done_cb_t done_cb = fade.done_cb;
+        void* user_ctx = fade.user_ctx;
+        xSemaphoreGive(fade.lock);
+
+        // Outside the lock, so the callback may start another fade
+        if (done_cb) {
+            done_cb(&rm690b0->base, ret, user_ctx);
+        }
+    }
+
+    // The caller must hold the fade lock
+    void stop_fade(Fade& fade) {
+        if (fade.active) {
+            esp_timer_stop(fade.timer);
+            fade.active = false;
+            fade.pending = -1;
+        }
+    }
+
+    void cancel_fade(const esp_lcd_panel_t* panel) {
+        Fade& fade = panel_cast(panel)->fade;
+
+        if (fade.lock) {
+            xSemaphoreTake(fade.lock, portMAX_DELAY);
+            stop_fade(fade);
+            xSemaphoreGive(fade.lock);
+        }
+    }
+
+    // Have the sleep timer go off delay_us from now, whether or not it was armed
+    void arm_sleep_timer(const Power& power, const uint64_t delay_us) {
+        esp_timer_stop(power.timer); // Fails if it isn't armed, which is fine
+        esp_timer_start_once(power.timer, delay_us);
+    }
+
+    // SLPOUT, once the controller has had its rest after SLPIN. Waits for the command gap after it, but not the
+    // 120 ms until the image shows: frame memory takes draws in the meantime. The caller must have the bus.
+    esp_err_t wake_up(const esp_lcd_panel_t* panel) {
+        const Power& power = panel_cast(panel)->power;
+
+        if (const int64_t rest_us = power.changed_us + Power::sleep_in_delay_us - esp_timer_get_time(); rest_us > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(rest_us));
+        }
+
+        return send_now(panel, LCDCmd{LCD_CMD_SLPOUT, {}, Power::wake_delay});
+    }
+
+    // Note the draw for auto-sleep, and wake a managed panel up for it
+    void wake_for_draw(const esp_lcd_panel_t* panel) {
+        Power& power = panel_cast(panel)->power;
+        power.last_draw_us = esp_timer_get_time();
+
+        if (!power.managed) {
+            return;
+        }
+
+        power.sleep_requested = false;
+        if (power.asleep) {
+            if (const esp_err_t ret = wake_up(panel); ret != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to wake the panel for a draw: %s", esp_err_to_name(ret));
+            }
+        }
+    }
+
+    // Put a managed panel to sleep once it is due: sleep_requested, or nothing drawn for auto_sleep_us, and
+    // never sooner than min_awake_us after SLPOUT. Runs from the esp_timer task.
+    void run_sleep_timer(void* arg) {
+        static constexpr uint64_t retry_us = 10'000;
+
+        auto* rm690b0 = static_cast<RM690B0Panel*>(arg);
+        Power& power = rm690b0->power;
+
+        if (power.asleep || (!power.sleep_requested && !power.auto_sleep_us)) {
+            return;
+        }
+
+        int64_t due_us = power.changed_us + Power::min_awake_us;
+        if (!power.sleep_requested) {
+            due_us = std::max<int64_t>(due_us, power.last_draw_us + static_cast<int64_t>(power.auto_sleep_us));
+        }
+
+        if (const int64_t now = esp_timer_get_time(); now < due_us) {
+            arm_sleep_timer(power, due_us - now);
+            return;
+        }
+
+        if (sequence_running(&rm690b0->base)) {
+            arm_sleep_timer(power, retry_us);
+            return;
+        }
+
+        // Queued behind the current draw if there is one, so no draw is cut short. Waiting for the bus would
+        // hold up every other timer, so with the queue full, try again later.
+        const esp_err_t ret = try_submit_command(&rm690b0->base, LCDCmd{LCD_CMD_SLPIN, {}, {}});
+        if (ret == ESP_ERR_NOT_FINISHED) {
+            arm_sleep_timer(power, retry_us);
+            return;
+        }
+
+        power.sleep_requested = false;
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Auto-sleep failed: %s", esp_err_to_name(ret));
+        }
+    }
+
+    // Start timing a flush, i.e. a draw_bitmap call or a batch commit, on the bus we have just claimed
+    void start_flush(const esp_lcd_panel_t* panel) {
+        Stats& stats = panel_cast(panel)->stats;
+
+        wake_for_draw(panel);
+
+        trace_start(trace_flush);
+        stats.flush_start_us = esp_timer_get_time();
+        stats.flush_window_us = 0;
+        stats.flush_te_wait_us = 0;
+        stats.flush_pixel_bytes = 0;
+    }
+
+    void begin_flush(const esp_lcd_panel_t* panel) {
+        claim_bus(panel);
+        start_flush(panel);
+    }
+
+    // Add the flush's figures to the totals. Its latency is recorded when its last transfer is done,
+    // or now if we don't see transfers finish.
+    void end_flush(const esp_lcd_panel_t* panel, const esp_err_t result) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        Stats& stats = rm690b0->stats;
+        rm690b0_stats_t& totals = stats.totals;
+
+        const int64_t elapsed = esp_timer_get_time() - stats.flush_start_us;
+        trace_stop(trace_flush);
+
+        portENTER_CRITICAL(&stats.lock);
+        ++totals.flush_calls;
+        totals.pixel_bytes += stats.flush_pixel_bytes;
+        totals.window_setup_time_us += stats.flush_window_us;
+        totals.te_wait_time_us += stats.flush_te_wait_us;
+        totals.color_time_us += elapsed - stats.flush_window_us - stats.flush_te_wait_us;
+        portEXIT_CRITICAL(&stats.lock);
+
+        if (result == ESP_OK && !rm690b0->transfers.io_callbacks_claimed) {
+            record_latency(stats, elapsed, stats.flush_pixel_bytes);
+        }
+
+        release_bus(panel);
+    }
+
+    // Whether `data` is one of the driver's framebuffers
+    bool is_framebuffer(const esp_lcd_panel_t* panel, const uint8_t* data) {
+        const Framebuffers& framebuffers = panel_cast(panel)->framebuffers;
+        const auto end = framebuffers.buffers.begin() + static_cast<std::ptrdiff_t>(framebuffers.count);
+
+        return std::any_of(framebuffers.buffers.begin(), end,
+                           [data](const DmaBuffer& buffer) { return buffer.get() == data; });
+    }
+
+    // Send `rect` from one of the driver's framebuffers, straight from PSRAM if the panel IO can DMA from it
+    esp_err_t draw_framebuffer(const esp_lcd_panel_t* panel, Rect rect, const uint8_t* framebuffer) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+        const Framebuffers& framebuffers = rm690b0->framebuffers;
+
+        ESP_RETURN_ON_FALSE(rect.x_start >= 0 && rect.y_start >= 0 && rect.x_end <= framebuffers.width &&
+                            rect.y_end <= framebuffers.height, ESP_ERR_INVALID_ARG, TAG, "area outside framebuffer");
+
+        // The framebuffer has the pixels to grow the area to the controller's alignment, unless it's at an edge
+        if (const Rect aligned = align_rect(panel, rect);
+            aligned.x_start >= 0 && aligned.y_start >= 0 && aligned.x_end <= framebuffers.width &&
+            aligned.y_end <= framebuffers.height) {
+            rect = aligned;
+        }
+
+        const size_t pixel_size = bytes_per_pixel(panel);
+        const size_t stride = framebuffers.width * pixel_size;
+        const PixelSource source = {
+            framebuffer + rect.y_start * stride + rect.x_start * pixel_size,
+            rect.width() * pixel_size,
+            stride,
+            static_cast<size_t>(rect.height()),
+        };
+
+        ESP_RETURN_ON_ERROR(begin_window(panel, rect, rm690b0->te.sync), TAG, "Failed to set up window"); // NOLINT
+
+        // A transfer per row costs more than copying the rows into the streaming buffers
+        if (!framebuffers.direct_dma || (!source.contiguous() && rm690b0->streaming.buffer_size)) {
+            return stream_pixels(panel, source, transfer_end_of_draw);
+        }
+
+        // The DMA reads PSRAM behind the cache, so write back what the CPU drew
+        const size_t span = (source.rows - 1) * source.stride + source.row_bytes;
+        ESP_RETURN_ON_ERROR(esp_cache_msync(const_cast<uint8_t*>(source.data), span, // NOLINT
+                                            ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED),
+                            TAG, "Failed to write back framebuffer");
+
+        return send_pixels(panel, source, transfer_end_of_draw);
+    }
+
+    // Whether draws need converting from the caller's format to `panel_format`
+    bool converting(const esp_lcd_panel_t* panel, rm690b0_pixel_format_t& panel_format) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+        return rm690b0->convert && panel_pixel_format(panel, panel_format) && panel_format != rm690b0->source_format;
+    }
+
+    // Allocate the fill buffer with the panel, so that fills and the draws detection turns into fills never
+    // allocate
+    esp_err_t alloc_fill(const esp_lcd_panel_t* panel) {
+        Fill& fill = panel_cast(panel)->fill;
+
+        fill.idle = xSemaphoreCreateBinary();
+        ESP_RETURN_ON_FALSE(fill.idle, ESP_ERR_NO_MEM, TAG, "no memory for fill semaphore");
+
+        fill.buffer.reset(static_cast<uint8_t*>(heap_caps_malloc(Fill::buffer_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL)));
+        ESP_RETURN_ON_FALSE(fill.buffer, ESP_ERR_NO_MEM, TAG, "no memory for fill buffer");
+
+        return ESP_OK;
+    }
+
+    // Fill transfers must be done before the buffer can be repainted, so fills need the transfer-done events.
+    // They are taken over on first use, leaving the panel IO's callback alone for panels that never fill.
+    esp_err_t init_fill(const esp_lcd_panel_t* panel) {
+        return claim_io_callbacks(panel);
+    }
+
+    // Make the fill buffer hold `pixel`, waiting for transfers of another color to finish first
+    void paint_fill(const esp_lcd_panel_t* panel, const uint8_t* pixel) {
+        Fill& fill = panel_cast(panel)->fill;
+        const size_t pixel_size = bytes_per_pixel(panel);
+
+        if (pixel_size == fill.pixel_size && std::equal(pixel, pixel + pixel_size, fill.pixel.begin())) {
+            return;
+        }
+
+        while (fill.in_flight) {
+            xSemaphoreTake(fill.idle, portMAX_DELAY);
+        }
+
+        std::copy_n(pixel, pixel_size, fill.pixel.begin());
+        fill.pixel_size = pixel_size;
+
+        uint8_t* buffer = fill.buffer.get();
+        for (size_t offset = 0; offset < Fill::buffer_size; offset += pixel_size) {
+            std::copy_n(pixel, pixel_size, buffer + offset);
+        }
+    }
+
+    // Fill `rect` with `pixel`, in the panel's format: RAMWR, then RAMWRC, each from the fill buffer
+    esp_err_t fill_window(const esp_lcd_panel_t* panel, const Rect& rect, const uint8_t* pixel, const bool wait_te,
+                          const uint8_t end_tag) {
+        Fill& fill = panel_cast(panel)->fill;
+
+        ESP_RETURN_ON_ERROR(begin_window(panel, rect, wait_te), TAG, "Failed to set up window"); // NOLINT
+        paint_fill(panel, pixel);
+
+        const TraceScope trace(trace_color);
+        const size_t size = color_bytes(panel, rect.area());
+
+        for (size_t offset = 0; offset < size;) {
+            const size_t length = std::min(Fill::buffer_size, size - offset);
+            const int lcd_cmd = pixel_prefix + ((offset == 0 ? LCD_CMD_RAMWR : LCD_CMD_RAMWRC) << 8);
+            offset += length;
+            const uint8_t tag = transfer_fill | (offset == size ? end_tag : 0);
+
+            ++fill.in_flight;
+            const esp_err_t ret = submit_color(panel, lcd_cmd, fill.buffer.get(), length, tag);
+            if (ret != ESP_OK) {
+                --fill.in_flight;
+                ESP_LOGE(TAG, "Failed to send fill ending at offset %zu: %s", offset, esp_err_to_name(ret));
+                return ret;
+            }
+        }
+
+        return ESP_OK;
+    }
+
+    // Read `rect` of frame memory into `buffer`: RAMRD, then RAMRDC, in chunks the panel IO can receive in one
+    // transaction. The caller must have claimed the bus.
+    esp_err_t read_window(const esp_lcd_panel_t* panel, const Rect& rect, uint8_t* buffer) {
+        // 4032 bytes hold whole pixels at any depth, and stay below the SPI driver's default maximum transfer
+        static constexpr size_t chunk_size = 4032;
+
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        const esp_lcd_panel_io_handle_t io = rm690b0->io; // NOLINT(*-misplaced-const)
+
+        ESP_RETURN_ON_FALSE(!sequence_running(panel), ESP_ERR_INVALID_STATE, TAG, "async sequence in progress");
+        ESP_RETURN_ON_FALSE(!batching(panel), ESP_ERR_INVALID_STATE, TAG, "command batch open");
+
+        const AddressWindow window = {
+            rect.x_start + rm690b0->x_gap,
+            rect.y_start + rm690b0->y_gap,
+            rect.x_end + rm690b0->x_gap - 1,
+            rect.y_end + rm690b0->y_gap - 1,
+        };
+
+        ESP_RETURN_ON_ERROR(set_window(panel, window), TAG, "Failed to set up window"); // NOLINT
+
+        const size_t size = color_bytes(panel, rect.area());
+        for (size_t offset = 0; offset < size;) {
+            const size_t length = std::min(chunk_size, size - offset);
+            const int lcd_cmd =
+                bus_command(panel, read_prefix + ((offset == 0 ? LCD_CMD_RAMRD : LCD_CMD_RAMRDC) << 8));
+
+            ++rm690b0->stats.commands;
+            ESP_RETURN_ON_ERROR(io->rx_param(io, lcd_cmd, buffer + offset, length), TAG, // NOLINT
+                                "Failed to read at offset %zu", offset);
+            offset += length;
+        }
+
+        return ESP_OK;
+    }
+
+    // Whether fill detection is on and every pixel of a draw is the same. If so, `pixel` is that pixel in
+    // the panel's format. Windows the driver would grow to its alignment are left to draw normally, and so
+    // are draws at a depth whose pixels don't fill whole bytes, which the fill buffer can't repeat.
+    bool single_color(const esp_lcd_panel_t* panel, const Rect& rect, const uint8_t* data,
+                      std::array<uint8_t, 3>& pixel) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        if (!rm690b0->fill.detect || !bytes_per_pixel(panel) || rect.empty() ||
+            (rm690b0->align.framebuffer && align_rect(panel, rect) != rect)) {
+            return false;
+        }
+
+        rm690b0_pixel_format_t panel_format{};
+        const bool convert = converting(panel, panel_format);
+        const size_t pixel_size =
+            convert ? esp_lcd_panel_rm690b0_pixel_format_size(rm690b0->source_format) : bytes_per_pixel(panel);
+
+        // Each pixel equals the next one, checked in one pass that stops at the first difference
+        if (std::memcmp(data, data + pixel_size, (rect.area() - 1) * pixel_size) != 0) {
+            return false;
+        }
+
+        if (convert) {
+            esp_lcd_panel_rm690b0_convert_pixels(rm690b0->source_format, data, panel_format, pixel.data(), 1);
+        } else {
+            std::copy_n(data, pixel_size, pixel.begin());
+        }
+
+        return true;
+    }
+
+    esp_err_t draw_pixels(const esp_lcd_panel_t* panel, const Rect& rect, const uint8_t* data) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        if (is_framebuffer(panel, data)) {
+            return draw_framebuffer(panel, rect, data);
+        }
+
+        if (std::array<uint8_t, 3> pixel{}; single_color(panel, rect, data, pixel)) {
+            return fill_window(panel, rect, pixel.data(), rm690b0->te.sync, transfer_end_of_draw);
+        }
+
+        rm690b0_pixel_format_t panel_format{};
+        if (converting(panel, panel_format)) {
+            const ConvertedSource source = {
+                .data = data,
+                .src_format = rm690b0->source_format,
+                .dst_format = panel_format,
+                .src_pixel_size = esp_lcd_panel_rm690b0_pixel_format_size(rm690b0->source_format),
+                .dst_pixel_size = bytes_per_pixel(panel),
+                .row_bytes = color_bytes(panel, rect.area()),
+            };
+
+            ESP_RETURN_ON_ERROR(begin_window(panel, rect, rm690b0->te.sync), TAG, // NOLINT
+                                "Failed to set up window");
+            return stream_pixels(panel, source, transfer_end_of_draw);
+        }
+
+        if (rm690b0->align.framebuffer) {
+            const Rect aligned = align_rect(panel, rect);
+
+            if (aligned.x_start != rect.x_start || aligned.y_start != rect.y_start ||
+                aligned.x_end != rect.x_end || aligned.y_end != rect.y_end) {
+                const AlignedSource source(data, rect, aligned, rm690b0->align.framebuffer, rm690b0->align.width,
+                                           rm690b0->align.height, bytes_per_pixel(panel));
+
+                ESP_RETURN_ON_ERROR(begin_window(panel, aligned, rm690b0->te.sync), TAG, // NOLINT
+                                    "Failed to set up window");
+                return stream_pixels(panel, source, transfer_end_of_draw);
+            }
+        }
+
+        const size_t color_size = color_bytes(panel, rect.area());
+        const PixelSource source = {data, color_size, color_size, 1};
+
+        return draw_window(panel, rect, source, rm690b0->te.sync, transfer_end_of_draw);
+    }
+
+    // Clip `rect` to the rows partial mode shows. False, leaving `rect` as is, if it shows none of them.
+    bool clip_rows_to_partial_area(const esp_lcd_panel_t* panel, Rect& rect) {
+        const PartialMode& partial = panel_cast(panel)->partial;
+
+        if (!partial.on) {
+            return true;
+        }
+
+        const int y_start = std::max(rect.y_start, partial.y_start);
+        const int y_end = std::min(rect.y_end, partial.y_end);
+
+        if (y_start >= y_end) {
+            return false;
+        }
+
+        rect.y_start = y_start;
+        rect.y_end = y_end;
+
+        return true;
+    }
+
+    bool clip_to_partial_area(const esp_lcd_panel_t* panel, Rect& rect, const uint8_t*& data) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+        const int y_start = rect.y_start;
+
+        // Without the IO's transfer-done events, we couldn't report a skipped draw as done, so draw all of it
+        if (!clip_rows_to_partial_area(panel, rect)) {
+            return !rm690b0->transfers.io_callbacks_claimed;
+        }
+
+        // The caller's rows are in the caller's format. Framebuffer draws find their rows from the area.
+        if (!is_framebuffer(panel, data)) {
+            rm690b0_pixel_format_t panel_format{};
+            const size_t row_bytes =
+                converting(panel, panel_format)
+                    ? rect.width() * esp_lcd_panel_rm690b0_pixel_format_size(rm690b0->source_format)
+                    : color_bytes(panel, rect.width());
+
+            data += (rect.y_start - y_start) * row_bytes;
+        }
+
+        return true;
+    }
+
+    // An area esp_lcd_panel_draw_bitmap() can send: not empty, and on the panel as far as we know its size
+    bool valid_draw_area(const esp_lcd_panel_t* panel, const Rect& rect) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        if (rect.empty() || rect.x_start < 0 || rect.y_start < 0) {
+            return false;
+        }
+
+        if (!rm690b0->width || !rm690b0->height) {
+            return true;
+        }
+
+        const int width = rm690b0->swap_xy ? rm690b0->height : rm690b0->width;
+        const int height = rm690b0->swap_xy ? rm690b0->width : rm690b0->height;
+        return rect.x_end <= width && rect.y_end <= height;
+    }
+
+    // Report a draw that sent nothing as done
+    esp_err_t skip_draw(const esp_lcd_panel_t* panel) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        const ColorTransfers& transfers = rm690b0->transfers;
+
+        if (transfers.cbs.on_color_trans_done) {
+            transfers.cbs.on_color_trans_done(&rm690b0->base, transfers.user_ctx);
+        }
+
+        return ESP_OK;
+    }
+
+    // NOLINTBEGIN(*-magic-numbers)
+    // The partial rows are in panel coordinates, and PTLAR takes the controller's lines, which run the other
+    // way if the scan direction or the software flip mirrors y. Without the panel height, they are taken as is.
+    LCDCmd partial_area_cmd(const esp_lcd_panel_t* panel) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+        const PartialMode& partial = rm690b0->partial;
+        const bool reversed = scroll_lines_reversed(panel) != software_flip(panel).y && rm690b0->height;
+
+        // PTLAR rows are inclusive, like RASET's
+        const int start = (reversed ? rm690b0->height - partial.y_end : partial.y_start) + rm690b0->y_gap;
+        const int end = (reversed ? rm690b0->height - partial.y_start : partial.y_end) + rm690b0->y_gap - 1;
+
+        return {
+            LCD_CMD_PTLAR,
+            {
+                static_cast<uint8_t>(start >> 8), static_cast<uint8_t>(start & 0xFF),
+                static_cast<uint8_t>(end >> 8), static_cast<uint8_t>(end & 0xFF),
+            },
+        };
+    }
+
+    // NOLINTEND(*-magic-numbers)
+
+    // Back to normal mode, e.g. because the partial rows would be along the other axis
+    esp_err_t stop_partial_mode(const esp_lcd_panel_t* panel) {
+        PartialMode& partial = panel_cast(panel)->partial;
+
+        if (!partial.on) {
+            return ESP_OK;
+        }
+
+        ESP_RETURN_ON_ERROR(send_command(panel, LCD_CMD_NORON), TAG, "NORON failed"); // NOLINT
+        partial.on = false;
+
+        return ESP_OK;
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    // ReSharper disable CppParameterMayBeConst
+    esp_err_t draw_bitmap(esp_lcd_panel_t* panel, int x_start, int y_start, int x_end, int y_end,
+                          const void* color_data) {
+        Rect rect = {x_start, y_start, x_end, y_end};
+        const auto* data = static_cast<const uint8_t*>(color_data);
+        ESP_RETURN_ON_FALSE(data && valid_draw_area(panel, rect), ESP_ERR_INVALID_ARG, TAG,
+                            "invalid draw area %d,%d-%d,%d", x_start, y_start, x_end, y_end);
+
+        if (!clip_to_partial_area(panel, rect, data)) {
+            return skip_draw(panel);
+        }
+
+        begin_flush(panel);
+        const esp_err_t ret = draw_pixels(panel, rect, data);
+        end_flush(panel, ret);
+
+        return ret;
+    }
+
+    // Count transfers in flight, so draws can wait for them to drain without blocking in the panel IO
+    esp_err_t init_backpressure(const esp_lcd_panel_t* panel) {
+        ColorTransfers& transfers = panel_cast(panel)->transfers;
+
+        if (transfers.drained) {
+            return ESP_OK;
+        }
+
+        ESP_RETURN_ON_ERROR(claim_io_callbacks(panel), TAG, "Failed to claim panel IO callbacks"); // NOLINT
+
+        transfers.drained = xSemaphoreCreateBinary();
+        ESP_RETURN_ON_FALSE(transfers.drained, ESP_ERR_NO_MEM, TAG, "no memory for transfer semaphore");
+
+        return ESP_OK;
+    }
+
+    // Wait until no transfer is in flight. Every command waits for that in the panel IO, so a draw started
+    // once they have drained won't stall behind earlier ones.
+    bool drain_until(const esp_lcd_panel_t* panel, const int64_t deadline_us) {
+        ColorTransfers& transfers = panel_cast(panel)->transfers;
+
+        // The semaphore may still hold a give from an earlier drain, so check again after every wake-up
+        while (transfers.completed != transfers.submitted) {
+            if (xSemaphoreTake(transfers.drained, ticks_until(deadline_us)) != pdTRUE) {
+                return transfers.completed == transfers.submitted;
+            }
+        }
+
+        return true;
+    }
+
+    // Claim the bus and wait for the transfers in flight, unless either takes past `deadline_us`. The fade
+    // step claim_bus sends waits for those transfers in the panel IO, so it goes only once they are out;
+    // on a timeout, it and any queued commands are left for the next owner rather than sent late.
+    bool claim_drained_bus_until(const esp_lcd_panel_t* panel, const int64_t deadline_us) {
+        if (!wait_for_bus(panel, deadline_us)) {
+            return false;
+        }
+
+        if (!drain_until(panel, deadline_us)) {
+            let_go_of_bus(panel);
+            return false;
+        }
+
+        apply_pending_brightness(panel);
+        return true;
+    }
+
+    // Whether a draw needs nothing but its window and its pixels: no clipping, conversion, alignment or fill
+    // detection, which all depend on the pixels or on the panel's current state.
+    bool plain_draw(const esp_lcd_panel_t* panel, const uint8_t* data) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+        rm690b0_pixel_format_t panel_format{};
+
+        return !rm690b0->partial.on && !rm690b0->fill.detect && !rm690b0->align.framebuffer &&
+            !converting(panel, panel_format) && !is_framebuffer(panel, data) && !software_flip(panel).any();
+    }
+
+    // Draw with a window and byte count prepared by the caller, e.g. at compile time by the C++ front end
+    esp_err_t draw_prepared(const esp_lcd_panel_t* panel, const rm690b0_prepared_draw_t& draw, const uint8_t* data) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        const AddressWindow window = {draw.x_start, draw.y_start, draw.x_end, draw.y_end};
+        const PixelSource source = {data, draw.size, draw.size, 1};
+
+        ESP_RETURN_ON_ERROR(begin_window(panel, window, rm690b0->te.sync), TAG, // NOLINT
+                            "Failed to set up window");
+
+        if (rm690b0->streaming.buffer_size && !esp_ptr_dma_capable(data)) {
+            return stream_pixels(panel, source, transfer_end_of_draw);
+        }
+
+        return send_pixels(panel, source, transfer_end_of_draw);
+    }
+
+    // NOLINTBEGIN(*-magic-numbers)
+    // Test pattern byte `index` of round `round`: alternating bits, full swings, then pseudo-random bytes
+    uint8_t link_test_byte(const unsigned round, const size_t index) {
+        switch (round % 3) {
+        case 0:
+            return index & 1 ? 0x55 : 0xAA;
+
+        case 1:
+            return index & 1 ? 0x00 : 0xFF;
+
+        default: {
+            uint32_t x = static_cast<uint32_t>(index) * 0x9E3779B1U + round;
+            x ^= x >> 15;
+            x *= 0x2C1B3C6DU;
+            return static_cast<uint8_t>(x >> 24);
+        }
+        }
+    }
+
+    // NOLINTEND(*-magic-numbers)
+
+    // Write test patterns to the top-left corner with RAMWR and read them back with RAMRD. `bad_bytes` counts the
+    // bytes that came back different.
+    esp_err_t test_link(esp_lcd_panel_t* panel, const unsigned rounds, size_t& bad_bytes) {
+        static constexpr Rect area = {0, 0, 32, 8};
+
+        const size_t size = color_bytes(panel, area.area());
+        const DmaBuffer written(static_cast<uint8_t*>(heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL)));
+        const DmaBuffer read(static_cast<uint8_t*>(heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL)));
+        ESP_RETURN_ON_FALSE(written && read, ESP_ERR_NO_MEM, TAG, "no memory for test patterns");
+
+        // The pattern must reach the panel as is
+        ESP_RETURN_ON_FALSE(plain_draw(panel, written.get()), ESP_ERR_INVALID_STATE, TAG,
+                            "partial mode, fill detection, alignment or conversion on");
+
+        // 18 bpp keeps the top six bits of each byte
+        const uint8_t mask = panel_cast(panel)->bits_per_pixel == 18 ? 0xFC : 0xFF; // NOLINT(*-magic-numbers)
+
+        bad_bytes = 0;
+        for (unsigned round = 0; round < rounds; ++round) {
+            for (size_t i = 0; i < size; ++i) {
+                written.get()[i] = link_test_byte(round, i) & mask;
+            }
+
+            ESP_RETURN_ON_ERROR(draw_bitmap(panel, area.x_start, area.y_start, area.x_end, area.y_end, // NOLINT
+                                            written.get()), TAG, "Failed to write test pattern");
+            ESP_RETURN_ON_ERROR(esp_lcd_panel_rm690b0_read_area(panel, area.x_start, area.y_start, // NOLINT
+                                                                area.x_end, area.y_end, read.get(), size),
+                                TAG, "Failed to read test pattern");
+
+            for (size_t i = 0; i < size; ++i) {
+                bad_bytes += written.get()[i] != read.get()[i];
+            }
+        }
+
+        return ESP_OK;
+    }
+
+    // Bring a panel up at `clock_hz` and test the link. False if it can't be trusted at that clock.
+    bool link_works(const rm690b0_clock_calibration_t& config, const uint32_t clock_hz) {
+        esp_lcd_panel_handle_t panel = nullptr;
+        size_t bad_bytes = 0;
+
+        esp_err_t ret = config.open_panel(clock_hz, &panel, config.user_ctx);
+        if (ret == ESP_OK) {
+            ret = test_link(panel, config.rounds, bad_bytes);
+            config.close_panel(panel, config.user_ctx);
+        }
+
+        if (ret != ESP_OK) {
+            ESP_LOGD(TAG, "%" PRIu32 " Hz: %s", clock_hz, esp_err_to_name(ret));
+            return false;
+        }
+
+        ESP_LOGD(TAG, "%" PRIu32 " Hz: %zu bad bytes", clock_hz, bad_bytes);
+        return bad_bytes == 0;
+    }
+
+    constexpr auto clock_nvs_key = "clock_hz";
+
+    // Draw a flush for the pipeline. If nothing ends up on the wire, the buffer is handed back from here.
+    void pipelined_flush(const esp_lcd_panel_t* panel, const FlushJob& job) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        ColorTransfers& transfers = rm690b0->transfers;
+        const Pipeline& pipeline = rm690b0->pipeline;
+
+        Rect rect = job.rect;
+        const auto* data = static_cast<const uint8_t*>(job.data);
+
+        esp_err_t ret = ESP_OK;
+        if (!clip_to_partial_area(panel, rect, data)) {
+            skip_draw(panel);
+        } else {
+            begin_flush(panel);
+            transfers.flush_buffer = job.data; // Only once we have the bus, so nobody else's draw picks it up
+            ret = draw_pixels(panel, rect, data);
+            transfers.flush_buffer = nullptr;
+            end_flush(panel, ret);
+
+            if (ret == ESP_OK) {
+                return;
+            }
+
+            // The draw's last transfer wasn't queued, so on_color_trans_done won't hand the buffer back
+            ESP_LOGE(TAG, "Pipelined flush failed: %s", esp_err_to_name(ret));
+        }
+
+        if (pipeline.done_cb) {
+            pipeline.done_cb(&rm690b0->base, job.data, pipeline.user_ctx);
+        }
+    }
+
+    void run_pipeline(void* arg) {
+        auto* rm690b0 = static_cast<RM690B0Panel*>(arg);
+        Pipeline& pipeline = rm690b0->pipeline;
+
+        FlushJob job{};
+        while (xQueueReceive(pipeline.jobs, &job, portMAX_DELAY) == pdTRUE && job.data) {
+            pipelined_flush(&rm690b0->base, job);
+        }
+
+        xSemaphoreGive(pipeline.stopped);
+        vTaskDelete(nullptr);
+    }
+
+    // Let the transfer task finish the flushes queued so far, then end it
+    void stop_pipeline(const esp_lcd_panel_t* panel) {
+        Pipeline& pipeline = panel_cast(panel)->pipeline;
+
+        constexpr FlushJob stop{};
+        xQueueSend(pipeline.jobs, &stop, portMAX_DELAY);
+        xSemaphoreTake(pipeline.stopped, portMAX_DELAY);
+
+        vQueueDelete(pipeline.jobs);
+        vSemaphoreDelete(pipeline.stopped);
+        pipeline.task = nullptr;
+        pipeline.jobs = nullptr;
+        pipeline.stopped = nullptr;
+    }
+
+    // Bus cost of sending `rect` as its own window, in pixel-byte equivalents
+    size_t window_cost(const DirtyBatch& batch, const Rect& rect, const size_t pixel_size) {
+        return rect.area() * pixel_size + batch.window_overhead_bytes;
+    }
+
+    // Find the pair of rectangles whose merge saves the most. Returns the saving, which is negative if
+    // merging any pair costs more than it saves.
+    int64_t best_merge(const DirtyBatch& batch, const size_t pixel_size, size_t& best_a, size_t& best_b) {
+        int64_t best_saving = INT64_MIN;
+
+        for (size_t a = 0; a < batch.count; ++a) {
+            for (size_t b = a + 1; b < batch.count; ++b) {
+                const Rect& rect_a = batch.rects.at(a);
+                const Rect& rect_b = batch.rects.at(b);
+
+                const auto separate = static_cast<int64_t>(window_cost(batch, rect_a, pixel_size) +
+                                                           window_cost(batch, rect_b, pixel_size));
+                const auto merged = static_cast<int64_t>(window_cost(batch, bounding_box(rect_a, rect_b), pixel_size));
+
+                if (separate - merged > best_saving) {
+                    best_saving = separate - merged;
+                    best_a = a;
+                    best_b = b;
+                }
+            }
+        }
+
+        return best_saving;
+    }
+
+    void merge_pair(DirtyBatch& batch, const size_t a, const size_t b) {
+        batch.rects.at(a) = bounding_box(batch.rects.at(a), batch.rects.at(b));
+        batch.rects.at(b) = batch.rects.at(batch.count - 1);
+        --batch.count;
+    }
+
+    // Merge rectangles for as long as it makes the frame cheaper to send
+    void merge_rects(DirtyBatch& batch, const size_t pixel_size) {
+        size_t a = 0;
+        size_t b = 0;
+
+        while (batch.count > 1 && best_merge(batch, pixel_size, a, b) >= 0) {
+            merge_pair(batch, a, b);
+        }
+    }
+
+    esp_err_t reset(gpio_num_t pin_num, const char* pin_name) {
+        if (pin_num == GPIO_NUM_NC) {
+            return ESP_OK;
+        }
+
+        const esp_err_t ret = gpio_reset_pin(pin_num);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to reset %s pin: %d", pin_name, ret);
+        } else {
+            ESP_LOGD(TAG, "%s pin reset", pin_name);
+        }
+
+        return ret;
+    }
+
+    void reset_all_pins(const esp_lcd_panel_t* panel) {
+        const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        reset(rm690b0->reset_gpio_num, "RESET");
+        reset(rm690b0->en_gpio_num, "EN");
+        reset(rm690b0->te.gpio_num, "TE");
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    // Let transfers still in flight finish, then stop the panel IO calling us: nothing the ISR touches may be
+    // freed before that. A transfer that never finishes is given up on after `timeout_us`.
+    void detach_io_callbacks(const esp_lcd_panel_t* panel, const int64_t timeout_us) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        const ColorTransfers& transfers = rm690b0->transfers;
+
+        if (!transfers.io_callbacks_claimed) {
+            return;
+        }
+
+        const int64_t deadline_us = esp_timer_get_time() + timeout_us;
+        while (transfers.completed != transfers.submitted && esp_timer_get_time() < deadline_us) {
+            vTaskDelay(1);
+        }
+
+        if (transfers.completed != transfers.submitted) {
+            ESP_LOGW(TAG, "%" PRIu32 " transfers still in flight", transfers.submitted - transfers.completed);
+        }
+
+        const esp_lcd_panel_io_callbacks_t no_callbacks = {};
+        if (const esp_err_t ret = esp_lcd_panel_io_register_event_callbacks(rm690b0->io, &no_callbacks, nullptr);
+            ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to unregister panel IO callbacks: %s", esp_err_to_name(ret));
+        }
+
+        rm690b0->transfers.io_callbacks_claimed = false;
+    }
+
+    esp_err_t del(esp_lcd_panel_t* panel) {
+        static constexpr int64_t drain_timeout_us = 1'000'000;
+
+        const std::unique_ptr<RM690B0Panel> owner(panel_cast(panel));
+
+        if (owner->pipeline.task) {
+            stop_pipeline(panel);
+        }
+
+        // The timers' callbacks use the bus, the locks and the state below, so they go first, and the drain
+        // catches whatever they sent last
+        if (owner->power.timer) {
+            esp_timer_stop(owner->power.timer);
+            esp_timer_delete(owner->power.timer);
+        }
+
+        if (owner->fade.timer) {
+            esp_timer_stop(owner->fade.timer);
+            esp_timer_delete(owner->fade.timer);
+        }
+
+        if (owner->sequence.timer) {
+            esp_timer_stop(owner->sequence.timer);
+            esp_timer_delete(owner->sequence.timer);
+        }
+
+        detach_io_callbacks(panel, drain_timeout_us);
+
+        if (owner->fade.lock) {
+            vSemaphoreDelete(owner->fade.lock);
+        }
+
+        if (owner->te.gpio_num != GPIO_NUM_NC) {
+            gpio_isr_handler_remove(owner->te.gpio_num);
+        }
+
+        if (owner->te.edge) {
+            vSemaphoreDelete(owner->te.edge);
+        }
+
+        if (owner->streaming.free_buffers) {
+            vSemaphoreDelete(owner->streaming.free_buffers);
+        }
+
+        if (owner->fill.idle) {
+            vSemaphoreDelete(owner->fill.idle);
+        }
+
+        if (owner->transfers.drained) {
+            vSemaphoreDelete(owner->transfers.drained);
+        }
+
+        if (owner->bus.released) {
+            vSemaphoreDelete(owner->bus.released);
+        }
+
+        if (owner->power.pm_lock) {
+            esp_pm_lock_delete(owner->power.pm_lock);
+        }
+
+        reset_all_pins(panel);
+        return ESP_OK;
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    esp_err_t invert_color(esp_lcd_panel_t* panel, bool invert_color_data) {
+        return send_command(panel, invert_color_data ? LCD_CMD_INVON : LCD_CMD_INVOFF);
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    esp_err_t swap_xy(esp_lcd_panel_t* panel, bool swap_axes) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        if (rm690b0->swap_xy != swap_axes) {
+            ESP_RETURN_ON_ERROR(stop_scrolling(panel), TAG, "Failed to stop scrolling"); // NOLINT
+            ESP_RETURN_ON_ERROR(stop_partial_mode(panel), TAG, "Failed to stop partial mode"); // NOLINT
+        }
+
+        rm690b0->swap_xy = swap_axes;
+        invalidate_window(panel);
+
+        return update_screen_orientation(panel);
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    esp_err_t mirror(esp_lcd_panel_t* panel, bool mirror_x, bool mirror_y) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        rm690b0->mirror_x = mirror_x;
+        rm690b0->mirror_y = mirror_y;
+        invalidate_window(panel);
+
+        if (mirror_x && (!rm690b0->swap_xy || mirror_y) && !software_flip(panel).any()) {
+            ESP_LOGW(TAG, "Set width and height in the vendor config to mirror x like this");
+        }
+
+        ESP_RETURN_ON_ERROR(update_screen_orientation(panel), TAG, "Failed to update orientation"); // NOLINT
+
+        // Mirroring y moves the partial rows to the other end of the controller's lines
+        if (rm690b0->partial.on) {
+            ESP_RETURN_ON_ERROR(send_command(panel, partial_area_cmd(panel)), TAG, "PTLAR failed"); // NOLINT
+        }
+
+        return update_scrolling(panel);
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    esp_err_t set_gap(esp_lcd_panel_t* panel, int x_gap, int y_gap) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+
+        rm690b0->x_gap = x_gap;
+        rm690b0->y_gap = y_gap;
+        invalidate_window(panel);
+
+        // The partial area's rows are in panel coordinates, so they move with the gap
+        if (rm690b0->partial.on) {
+            return send_command(panel, partial_area_cmd(panel));
+        }
+
+        return ESP_OK;
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    esp_err_t disp_on_off(esp_lcd_panel_t* panel, bool on_off) {
+        const uint8_t command_code = on_off ? LCD_CMD_DISPON : LCD_CMD_DISPOFF;
+        return send_command(panel, command_code);
+    }
+
+    // ReSharper disable once CppParameterMayBeConstPtrOrRef
+    esp_err_t sleep(esp_lcd_panel_t* panel, bool sleep) {
+        Power& power = panel_cast(panel)->power;
+
+        if (!power.managed) {
+            const uint8_t command_code = sleep ? LCD_CMD_SLPIN : LCD_CMD_SLPOUT;
+            return send_command(panel, command_code);
+        }
+
+        // The sleep timer sends SLPIN as soon as the controller allows, so we don't wait here
+        power.sleep_requested = sleep;
+        if (sleep) {
+            arm_sleep_timer(power, 0);
+            return ESP_OK;
+        }
+
+        if (!power.asleep) {
+            return ESP_OK;
+        }
+
+        claim_bus(panel);
+        const esp_err_t ret = wake_up(panel);
+        release_bus(panel);
+
+        return ret;
+    }
+
+
+    // Initialize a GPIO pin for output.
+    // If this operation fails, *all* output pins are reset.
+    esp_err_t init_out_pin(const esp_lcd_panel_t* panel, gpio_num_t pin, const char* pin_name) {
+        if (pin == GPIO_NUM_NC) {
+            return ESP_OK;
+        }
+
+        const gpio_config_t io_conf = {
+            .pin_bit_mask = 1ULL << pin,
+            .mode = GPIO_MODE_OUTPUT,
+            .pull_up_en = GPIO_PULLUP_DISABLE,
+            .pull_down_en = GPIO_PULLDOWN_DISABLE,
+            .intr_type = GPIO_INTR_DISABLE,
+        };
+
+        ESP_LOGD(TAG, "Configuring %s pin (GPIO %d) as output", pin_name, pin);
+        const esp_err_t ret = gpio_config(&io_conf);
+
+        if (ret != ESP_OK) {
+            reset_all_pins(panel);
+        }
+
+        return ret;
+    }
+    // Initialize the TE pin as an interrupt input.
+    // If this operation fails, *all* pins are reset.
+    esp_err_t init_te_pin(const esp_lcd_panel_t* panel) {
+        RM690B0Panel* rm690b0 = panel_cast(panel);
+        TearingEffect& te = rm690b0->te;
+
+        if (te.gpio_num == GPIO_NUM_NC) {
+            return ESP_OK;
+        }
+
+        const gpio_config_t io_conf = {
+            .pin_bit_mask = 1ULL << te.gpio_num,
+            .mode = GPIO_MODE_INPUT,
+            .pull_up_en = GPIO_PULLUP_DISABLE,
+            .pull_down_en = GPIO_PULLDOWN_DISABLE,
+            .intr_type = GPIO_INTR_POSEDGE,
+        };
+
+        ESP_LOGD(TAG, "Configuring TE pin (GPIO %d) as input", te.gpio_num);
+        esp_err_t ret = gpio_config(&io_conf);
+
+        te.edge = ret == ESP_OK ? xSemaphoreCreateBinary() : nullptr;
+        if (ret == ESP_OK && !te.edge) {
+            ret = ESP_ERR_NO_MEM;
+        }
+
+        if (ret == ESP_OK) {
+            // The ISR service may already have been installed by the application or another driver
+            ret = gpio_install_isr_service(0);
+            if (ret == ESP_ERR_INVALID_STATE) {
+                ret = ESP_OK;
+            }
+        }
+
+        if (ret == ESP_OK) {
+            ret = gpio_isr_handler_add(te.gpio_num, te_isr_handler, rm690b0);
+        }
+
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set up TE pin: %s", esp_err_to_name(ret));
+
+            if (te.edge) {
+                vSemaphoreDelete(te.edge);
+                te.edge = nullptr;
+            }
+
+            reset_all_pins(panel);
+        }
+
+        return ret;
+    }
+}
+
+uint8_t esp_lcd_panel_rm690b0_get_brightness(const esp_lcd_panel_t* panel) {
+    const RM690B0Panel* rm690b0 = panel_cast(panel);
+    return rm690b0->brightness;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_set_brightness(const esp_lcd_panel_t* panel, uint8_t brightness) {
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+    cancel_fade(panel);
+    rm690b0->brightness = brightness;
+
+    return send_command(panel, lcd_cmd_write_display_brightness, {brightness});
+}
+
+esp_err_t esp_lcd_panel_rm690b0_warm_init(const esp_lcd_panel_t* panel, bool* warm) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    ESP_RETURN_ON_FALSE(!sequence_running(panel), ESP_ERR_INVALID_STATE, TAG, "async sequence in progress");
+    invalidate_window(panel);
+
+    const int64_t start = esp_timer_get_time();
+    bool was_warm = false;
+
+    if (warm_start(panel, was_warm) != ESP_OK || !was_warm) {
+        // Fall back to a cold start: the panel is in an unknown state
+        ESP_RETURN_ON_ERROR(run_steps(panel, {.reset = true, .init = true, .command = std::nullopt}), TAG, // NOLINT
+                            "Failed to send init commands to display");
+        was_warm = false;
+    }
+
+    record_init_time(panel, esp_timer_get_time() - start);
+
+    if (warm) {
+        *warm = was_warm;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_fade_brightness(const esp_lcd_panel_t* panel, uint8_t target, uint32_t duration_ms,
+                                                rm690b0_fade_curve_t curve, esp_lcd_panel_rm690b0_done_cb_t done_cb,
+                                                void* user_ctx) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+    Fade& fade = rm690b0->fade;
+
+    // Steps are only sent from the timer once the pixels before them are out, which takes transfer-done events
+    ESP_RETURN_ON_ERROR(claim_io_callbacks(panel), TAG, "Failed to claim panel IO callbacks"); // NOLINT
+
+    if (!fade.lock) {
+        fade.lock = xSemaphoreCreateMutex();
+        ESP_RETURN_ON_FALSE(fade.lock, ESP_ERR_NO_MEM, TAG, "no memory for fade lock");
+    }
+
+    if (!fade.timer) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = run_fade,
+            .arg = rm690b0,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "rm690b0_fade",
+            .skip_unhandled_events = true,
+        };
+
+        ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &fade.timer), TAG, "Failed to create fade timer"); // NOLINT
+    }
+
+    xSemaphoreTake(fade.lock, portMAX_DELAY);
+
+    // A new fade replaces one in progress, starting from wherever that one got to
+    stop_fade(fade);
+
+    fade.from = rm690b0->brightness;
+    fade.to = target;
+    fade.start_us = esp_timer_get_time();
+    fade.duration_us = duration_ms * 1000; // NOLINT(*-magic-numbers)
+    fade.curve = curve;
+    fade.done_cb = done_cb;
+    fade.user_ctx = user_ctx;
+    fade.active = true;
+
+    const esp_err_t ret = esp_timer_start_periodic(fade.timer, Fade::step_period_us);
+    if (ret != ESP_OK) {
+        fade.active = false;
+    }
+
+    xSemaphoreGive(fade.lock);
+    return ret;
+}
+
+bool esp_lcd_panel_rm690b0_is_fading(const esp_lcd_panel_t* panel) {
+    return panel_cast(panel)->fade.active;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_init_async(const esp_lcd_panel_t* panel, bool reset,
+                                           esp_lcd_panel_rm690b0_done_cb_t done_cb, void* user_ctx) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    ESP_RETURN_ON_FALSE(!sequence_running(panel), ESP_ERR_INVALID_STATE, TAG, "async sequence in progress");
+    invalidate_window(panel);
+
+    return start_async_sequence(panel, {.reset = reset, .init = true, .command = std::nullopt}, done_cb, user_ctx);
+}
+
+esp_err_t esp_lcd_panel_rm690b0_sleep_async(const esp_lcd_panel_t* panel, bool sleep,
+                                            esp_lcd_panel_rm690b0_done_cb_t done_cb, void* user_ctx) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+
+    const uint8_t command_code = sleep ? LCD_CMD_SLPIN : LCD_CMD_SLPOUT;
+
+    return start_async_sequence(panel, {.reset = false, .init = false, .command = command_code}, done_cb, user_ctx);
+}
+
+bool esp_lcd_panel_rm690b0_is_busy(const esp_lcd_panel_t* panel) {
+    return sequence_running(panel);
+}
+
+esp_err_t esp_lcd_panel_rm690b0_enable_power_manager(const esp_lcd_panel_t* panel,
+                                                     const rm690b0_power_config_t* config) {
+    ESP_RETURN_ON_FALSE(panel && config, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+    Power& power = rm690b0->power;
+
+    if (!power.timer) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = run_sleep_timer,
+            .arg = rm690b0,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "rm690b0_sleep",
+            .skip_unhandled_events = true,
+        };
+
+        ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &power.timer), TAG, "Failed to create sleep timer"); // NOLINT
+    }
+
+    if (config->hold_pm_lock && !power.pm_lock) {
+        // The ISR releases the lock, so it must see every transfer finish
+        ESP_RETURN_ON_ERROR(claim_io_callbacks(panel), TAG, "Failed to claim panel IO callbacks"); // NOLINT
+
+        // Without power management, nothing lowers the clock, so there is nothing to hold it up against
+        if (const esp_err_t ret = esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "rm690b0", &power.pm_lock);
+            ret == ESP_ERR_NOT_SUPPORTED) {
+            ESP_LOGD(TAG, "Power management disabled, no PM lock");
+        } else {
+            ESP_RETURN_ON_ERROR(ret, TAG, "Failed to create PM lock"); // NOLINT
+        }
+    }
+
+    power.use_pm_lock = config->hold_pm_lock;
+    power.auto_sleep_us = uint64_t{config->auto_sleep_ms} * 1000; // NOLINT(*-magic-numbers)
+    power.last_draw_us = esp_timer_get_time();
+    power.managed = true;
+
+    if (!power.asleep && power.auto_sleep_us) {
+        arm_sleep_timer(power, power.auto_sleep_us);
+    }
+
+    return ESP_OK;
+}
+
+rm690b0_power_state_t esp_lcd_panel_rm690b0_get_power_state(const esp_lcd_panel_t* panel) {
+    const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+    if (rm690b0->power.asleep) {
+        return RM690B0_POWER_SLEEP;
+    }
+
+    if (!rm690b0->power.display_on) {
+        return RM690B0_POWER_DISPLAY_OFF;
+    }
+
+    if (rm690b0->partial.on) {
+        return RM690B0_POWER_PARTIAL;
+    }
+
+    return rm690b0->idle ? RM690B0_POWER_IDLE : RM690B0_POWER_ACTIVE;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_register_event_callbacks(const esp_lcd_panel_t* panel,
+                                                        const rm690b0_event_callbacks_t* cbs, void* user_ctx) {
+    ESP_RETURN_ON_FALSE(panel && cbs, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+
+    ESP_RETURN_ON_ERROR(claim_io_callbacks(panel), TAG, "Failed to claim panel IO callbacks"); // NOLINT
+
+    rm690b0->transfers.cbs = *cbs;
+    rm690b0->transfers.user_ctx = user_ctx;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_set_te_sync(const esp_lcd_panel_t* panel, bool enable) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+    ESP_RETURN_ON_FALSE(rm690b0->te.edge, ESP_ERR_INVALID_STATE, TAG, "no TE pin configured");
+
+    rm690b0->te.sync = enable;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_register_vsync_cb(const esp_lcd_panel_t* panel,
+                                                  esp_lcd_panel_rm690b0_vsync_cb_t vsync_cb, void* user_ctx) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+    ESP_RETURN_ON_FALSE(rm690b0->te.edge, ESP_ERR_INVALID_STATE, TAG, "no TE pin configured");
+
+    portENTER_CRITICAL(&rm690b0->te.lock);
+    rm690b0->te.vsync_cb = vsync_cb;
+    rm690b0->te.vsync_ctx = user_ctx;
+    portEXIT_CRITICAL(&rm690b0->te.lock);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_get_frame_timing(const esp_lcd_panel_t* panel, rm690b0_frame_timing_t* timing) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    ESP_RETURN_ON_FALSE(timing, ESP_ERR_INVALID_ARG, TAG, "timing must not be null");
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+    ESP_RETURN_ON_FALSE(rm690b0->te.edge, ESP_ERR_INVALID_STATE, TAG, "no TE pin configured");
+
+    portENTER_CRITICAL(&rm690b0->te.lock);
+    timing->period_us = rm690b0->te.period_us;
+    timing->last_te_time_us = rm690b0->te.last_edge_us;
+    timing->te_count = rm690b0->te.edge_count;
+    portEXIT_CRITICAL(&rm690b0->te.lock);
+
+    return timing->period_us ? ESP_OK : ESP_ERR_NOT_FINISHED;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_get_alignment(const esp_lcd_panel_t* panel, int* x_align, int* y_align) {
+    ESP_RETURN_ON_FALSE(panel && x_align && y_align, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    *x_align = column_alignment;
+    *y_align = row_alignment;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_align_area(const esp_lcd_panel_t* panel, int* x_start, int* y_start, int* x_end,
+                                           int* y_end) {
+    ESP_RETURN_ON_FALSE(panel && x_start && y_start && x_end && y_end, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+
+    const Rect aligned = align_rect(panel, {*x_start, *y_start, *x_end, *y_end});
+    *x_start = aligned.x_start;
+    *y_start = aligned.y_start;
+    *x_end = aligned.x_end;
+    *y_end = aligned.y_end;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_set_color_depth(const esp_lcd_panel_t* panel, uint8_t bits_per_pixel,
+                                                bool grayscale) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    ESP_RETURN_ON_FALSE(!sequence_running(panel), ESP_ERR_INVALID_STATE, TAG, "async sequence in progress");
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+
+    ESP_RETURN_ON_FALSE(!rm690b0->batch.open, ESP_ERR_INVALID_STATE, TAG, "can't switch color depth during a batch");
+    ESP_RETURN_ON_FALSE(!rm690b0->framebuffers.count, ESP_ERR_INVALID_STATE, TAG,
+                        "framebuffers are in the current color depth");
+
+    const uint8_t old_bits_per_pixel = rm690b0->bits_per_pixel;
+    const bool old_grayscale = rm690b0->grayscale;
+    rm690b0->bits_per_pixel = bits_per_pixel;
+    rm690b0->grayscale = grayscale;
+
+    const esp_err_t ret = send_color_depth(panel);
+
+    if (ret != ESP_OK) {
+        rm690b0->bits_per_pixel = old_bits_per_pixel;
+        rm690b0->grayscale = old_grayscale;
+    }
+
+    return ret;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_set_align_framebuffer(const esp_lcd_panel_t* panel, const void* framebuffer,
+                                                      int width, int height) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+
+    if (framebuffer) {
+        ESP_RETURN_ON_FALSE(width > 0 && height > 0, ESP_ERR_INVALID_ARG, TAG, "invalid framebuffer size");
+        ESP_RETURN_ON_FALSE(bytes_per_pixel(panel), ESP_ERR_NOT_SUPPORTED, TAG,
+                            "alignment needs a whole number of bytes per pixel");
+        ESP_RETURN_ON_FALSE(rm690b0->streaming.buffer_size, ESP_ERR_INVALID_STATE, TAG,
+                            "alignment needs streaming buffers");
+        ESP_RETURN_ON_FALSE(!rm690b0->convert, ESP_ERR_INVALID_STATE, TAG,
+                            "alignment can't be combined with format conversion");
+    }
+
+    rm690b0->align.framebuffer = static_cast<const uint8_t*>(framebuffer);
+    rm690b0->align.width = width;
+    rm690b0->align.height = height;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_set_source_format(const esp_lcd_panel_t* panel, rm690b0_pixel_format_t format) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+
+    rm690b0_pixel_format_t panel_format{};
+    ESP_RETURN_ON_FALSE(panel_pixel_format(panel, panel_format), ESP_ERR_NOT_SUPPORTED, TAG,
+                        "no conversion to %d bits per pixel", rm690b0->bits_per_pixel);
+    ESP_RETURN_ON_FALSE(esp_lcd_panel_rm690b0_pixel_format_size(format), ESP_ERR_NOT_SUPPORTED, TAG,
+                        "unknown pixel format %d", format);
+
+    if (format == panel_format) {
+        rm690b0->convert = false;
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_FALSE(rm690b0->streaming.buffer_size, ESP_ERR_INVALID_STATE, TAG,
+                        "format conversion needs streaming buffers");
+    ESP_RETURN_ON_FALSE(!rm690b0->align.framebuffer, ESP_ERR_INVALID_STATE, TAG,
+                        "format conversion can't be combined with alignment");
+
+    rm690b0->source_format = format;
+    rm690b0->convert = true;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_set_scroll_area(const esp_lcd_panel_t* panel, int top_fixed, int scroll_lines,
+                                                int bottom_fixed) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    ESP_RETURN_ON_FALSE(top_fixed >= 0 && scroll_lines > 0 && bottom_fixed >= 0 &&
+                        top_fixed + scroll_lines + bottom_fixed <= UINT16_MAX, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid scroll area");
+    Scrolling& scrolling = panel_cast(panel)->scrolling;
+
+    scrolling = {
+        .defined = true,
+        .top_fixed = static_cast<uint16_t>(top_fixed),
+        .lines = static_cast<uint16_t>(scroll_lines),
+        .bottom_fixed = static_cast<uint16_t>(bottom_fixed),
+    };
+
+    return update_scrolling(panel);
+}
+
+esp_err_t esp_lcd_panel_rm690b0_scroll_to(const esp_lcd_panel_t* panel, int offset) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    Scrolling& scrolling = panel_cast(panel)->scrolling;
+    ESP_RETURN_ON_FALSE(scrolling.defined, ESP_ERR_INVALID_STATE, TAG, "no scroll area set");
+
+    const int lines = scrolling.lines;
+    scrolling.offset = static_cast<uint16_t>((offset % lines + lines) % lines);
+
+    return send_command(panel, scroll_start_cmd(panel));
+}
+
+esp_err_t esp_lcd_panel_rm690b0_scroll_map_line(const esp_lcd_panel_t* panel, int line, int* draw_line) {
+    ESP_RETURN_ON_FALSE(panel && draw_line, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    const RM690B0Panel* rm690b0 = panel_cast(panel);
+    const Scrolling& scrolling = rm690b0->scrolling;
+
+    *draw_line = line;
+
+    if (!scrolling.defined) {
+        return ESP_OK;
+    }
+
+    // Scroll area counts include the gap, draw coordinates don't
+    const int gap = rm690b0->swap_xy ? rm690b0->x_gap : rm690b0->y_gap;
+    const int position = line + gap - scrolling.top_fixed;
+
+    if (position >= 0 && position < scrolling.lines) {
+        *draw_line = scrolling.top_fixed + (position + scrolling.offset) % scrolling.lines - gap;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_set_partial_mode(const esp_lcd_panel_t* panel, bool enable, int y_start, int y_end) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+    PartialMode& partial = rm690b0->partial;
+
+    if (!enable) {
+        return stop_partial_mode(panel);
+    }
+
+    ESP_RETURN_ON_FALSE(y_start >= 0 && y_start < y_end, ESP_ERR_INVALID_ARG, TAG, "invalid partial area");
+    ESP_RETURN_ON_FALSE(!rm690b0->swap_xy, ESP_ERR_NOT_SUPPORTED, TAG, "partial mode needs unswapped axes");
+
+    const PartialMode previous = partial;
+    partial = {.on = true, .y_start = y_start, .y_end = y_end};
+
+    esp_err_t ret = send_command(panel, partial_area_cmd(panel));
+    if (ret == ESP_OK && !previous.on) {
+        ret = send_command(panel, LCD_CMD_PTLON);
+    }
+
+    if (ret != ESP_OK) {
+        partial = previous;
+    }
+
+    return ret;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_set_idle_mode(const esp_lcd_panel_t* panel, bool enable) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+
+    const uint8_t command_code = enable ? LCD_CMD_IDMON : LCD_CMD_IDMOFF;
+    ESP_RETURN_ON_ERROR(send_command(panel, command_code), TAG, "Failed to set idle mode"); // NOLINT
+    rm690b0->idle = enable;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_get_display_mode(const esp_lcd_panel_t* panel, bool* partial, int* y_start,
+                                                 int* y_end, bool* idle) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    const RM690B0Panel* rm690b0 = panel_cast(panel);
+
+    if (partial) {
+        *partial = rm690b0->partial.on;
+    }
+
+    if (y_start) {
+        *y_start = rm690b0->partial.y_start;
+    }
+
+    if (y_end) {
+        *y_end = rm690b0->partial.y_end;
+    }
+
+    if (idle) {
+        *idle = rm690b0->idle;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_cmd_batch_begin(const esp_lcd_panel_t* panel) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    ESP_RETURN_ON_FALSE(!batching(panel), ESP_ERR_INVALID_STATE, TAG, "command batch already open");
+
+    // Another task's batch holds the bus until it is committed, so there's only ever one open
+    claim_bus(panel);
+
+    CommandBatch& batch = panel_cast(panel)->commands;
+    batch.count = 0;
+    batch.owner = xTaskGetCurrentTaskHandle();
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_cmd_batch_commit(const esp_lcd_panel_t* panel) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    ESP_RETURN_ON_FALSE(batching(panel), ESP_ERR_INVALID_STATE, TAG, "no command batch open");
+
+    // Still under the claim taken by cmd_batch_begin: nothing gets between the commands
+    CommandBatch& batch = panel_cast(panel)->commands;
+    batch.owner = nullptr;
+
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < batch.count && ret == ESP_OK; ++i) {
+        ret = send_now(panel, batch.cmds.at(i));
+    }
+
+    batch.count = 0;
+    release_bus(panel);
+
+    return ret;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_batch_begin(const esp_lcd_panel_t* panel, const rm690b0_batch_config_t* config) {
+    ESP_RETURN_ON_FALSE(panel && config && config->framebuffer, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->width > 0 && config->height > 0, ESP_ERR_INVALID_ARG, TAG, "invalid framebuffer size");
+    ESP_RETURN_ON_FALSE(bytes_per_pixel(panel), ESP_ERR_NOT_SUPPORTED, TAG,
+                        "batching needs a whole number of bytes per pixel");
+
+    DirtyBatch& batch = panel_cast(panel)->batch;
+    ESP_RETURN_ON_FALSE(!batch.open, ESP_ERR_INVALID_STATE, TAG, "batch already open");
+
+    batch.framebuffer = static_cast<const uint8_t*>(config->framebuffer);
+    batch.width = config->width;
+    batch.height = config->height;
+    batch.window_overhead_bytes = config->window_overhead_bytes
+                                      ? config->window_overhead_bytes
+                                      : DirtyBatch::default_window_overhead_bytes;
+    batch.count = 0;
+    batch.open = true;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_batch_add(const esp_lcd_panel_t* panel, int x_start, int y_start, int x_end,
+                                          int y_end) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+
+    DirtyBatch& batch = panel_cast(panel)->batch;
+    ESP_RETURN_ON_FALSE(batch.open, ESP_ERR_INVALID_STATE, TAG, "no batch open");
+
+    // The batch has the whole framebuffer, so it can always grow rectangles to the controller's alignment
+    const Rect aligned = align_rect(panel, {x_start, y_start, x_end, y_end});
+    const Rect rect = {
+        std::max(aligned.x_start, 0), std::max(aligned.y_start, 0),
+        std::min(aligned.x_end, batch.width), std::min(aligned.y_end, batch.height)
+    };
+
+    if (rect.empty()) {
+        return ESP_OK;
+    }
+
+    const size_t pixel_size = bytes_per_pixel(panel);
+
+    // Make room by merging the pair that costs the least to merge, even if that costs more than it saves
+    if (batch.count == DirtyBatch::max_rects) {
+        size_t a = 0;
+        size_t b = 0;
+        best_merge(batch, pixel_size, a, b);
+        merge_pair(batch, a, b);
+    }
+
+    batch.rects.at(batch.count++) = rect;
+    ++batch.stats.rects_in;
+    batch.stats.bytes_in += rect.area() * pixel_size;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_batch_commit(const esp_lcd_panel_t* panel) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+    DirtyBatch& batch = rm690b0->batch;
+    ESP_RETURN_ON_FALSE(batch.open, ESP_ERR_INVALID_STATE, TAG, "no batch open");
+    batch.open = false;
+
+    const size_t pixel_size = bytes_per_pixel(panel);
+    const size_t stride = batch.width * pixel_size;
+
+    merge_rects(batch, pixel_size);
+
+    // Nothing dirty is still a frame: whoever waits for on_color_trans_done, like LVGL, would wait for good
+    if (!batch.count) {
+        return skip_draw(panel);
+    }
+
+    begin_flush(panel);
+    esp_err_t ret = ESP_OK;
+
+    for (size_t i = 0; i < batch.count && ret == ESP_OK; ++i) {
+        const Rect& rect = batch.rects.at(i);
+        const PixelSource source = {
+            batch.framebuffer + rect.y_start * stride + rect.x_start * pixel_size,
+            rect.width() * pixel_size,
+            stride,
+            static_cast<size_t>(rect.height()),
+        };
+
+        // Only wait for TE once per frame, and report the frame as one draw
+        const bool first = i == 0;
+        const bool last = i + 1 == batch.count;
+        ret = draw_window(panel, rect, source, first && rm690b0->te.sync, last ? transfer_end_of_draw : 0);
+
+        // Only windows that went out count as sent
+        if (ret == ESP_OK) {
+            ++batch.stats.rects_out;
+            batch.stats.bytes_out += source.size();
+        }
+    }
+
+    end_flush(panel, ret);
+    ESP_RETURN_ON_ERROR(ret, TAG, "Failed to draw batched window"); // NOLINT
+
+    const uint64_t overhead = batch.window_overhead_bytes;
+    batch.stats.bytes_saved = static_cast<int64_t>(batch.stats.bytes_in + batch.stats.rects_in * overhead) -
+                              static_cast<int64_t>(batch.stats.bytes_out + batch.stats.rects_out * overhead);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_get_batch_stats(const esp_lcd_panel_t* panel, rm690b0_batch_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(panel && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    *stats = panel_cast(panel)->batch.stats;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_get_stats(const esp_lcd_panel_t* panel, rm690b0_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(panel && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    Stats& panel_stats = panel_cast(panel)->stats;
+
+    uint64_t latency_total_us = 0;
+    uint64_t latency_bytes = 0;
+
+    portENTER_CRITICAL(&panel_stats.lock);
+    *stats = panel_stats.totals;
+    latency_total_us = panel_stats.latency_total_us;
+    latency_bytes = panel_stats.latency_bytes;
+    portEXIT_CRITICAL(&panel_stats.lock);
+
+    stats->command_count = panel_stats.commands;
+    stats->bus = panel_cast(panel)->backend->bus;
+
+    if (stats->flush_count) {
+        stats->latency_avg_us = static_cast<uint32_t>(latency_total_us / stats->flush_count);
+    }
+
+    // Bytes per microsecond are megabytes per second
+    if (latency_total_us) {
+        stats->throughput_mb_per_s = static_cast<float>(latency_bytes) / static_cast<float>(latency_total_us);
+    }
+
+    if (stats->readback_time_us) {
+        stats->readback_mb_per_s =
+            static_cast<float>(stats->readback_bytes) / static_cast<float>(stats->readback_time_us);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_rm690b0_reset_stats(const esp_lcd_panel_t* panel) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    Stats& stats = panel_cast(panel)->stats;
+
+    portENTER_CRITICAL(&stats.lock);
+    const uint32_t init_time_us = stats.totals.init_time_us;
+    stats.totals = {};
+    stats.totals.init_time_us = init_time_us;
+    stats.latency_total_us = 0;
+    stats.latency_bytes = 0;
+    portEXIT_CRITICAL(&stats.lock);
+
+    stats.commands = 0;
+
+    return ESP_OK;
+}
 
-            case LCD_CMD_DISPON:
-            case lcd_cmd_set_disp_mode:
-                delay = 10ms;
-                break;
+int esp_lcd_panel_rm690b0_format_stats(const rm690b0_stats_t* stats, char* buffer, size_t size) {
+    ESP_RETURN_ON_FALSE(stats && (buffer || !size), -1, TAG, "invalid argument");
 
-            default:
-                delay = 0ms;
-            }
-        }
+    return snprintf(buffer, size,
+                    R"({"commands":%)" PRIu32 R"(,"flushes":%)" PRIu32 R"(,"flush_calls":%)" PRIu32
+                    R"(,"pixel_bytes":%)" PRIu64
+                    R"(,"window_setup_us":%)" PRIu64 R"(,"te_wait_us":%)" PRIu64 R"(,"color_us":%)" PRIu64
+                    R"(,"latency_min_us":%)" PRIu32 R"(,"latency_avg_us":%)" PRIu32 R"(,"latency_max_us":%)" PRIu32
+                    R"(,"mb_per_s":%.3f,"init_us":%)" PRIu32 R"(,"read_bytes":%)" PRIu64
+                    R"(,"read_us":%)" PRIu64 R"(,"read_mb_per_s":%.3f,"bus":"%s"})",
+                    stats->command_count, stats->flush_count, stats->flush_calls, stats->pixel_bytes,
+                    stats->window_setup_time_us,
+                    stats->te_wait_time_us, stats->color_time_us, stats->latency_min_us, stats->latency_avg_us,
+                    stats->latency_max_us, static_cast<double>(stats->throughput_mb_per_s), stats->init_time_us,
+                    stats->readback_bytes, stats->readback_time_us, static_cast<double>(stats->readback_mb_per_s),
+                    static_cast<size_t>(stats->bus) < bus_backends.size() ? bus_backends.at(stats->bus).name : "?");
+}
 
-        int32_t lcd_cmd;
-        std::vector<uint8_t> param;
-        std::chrono::milliseconds delay{};
-    };
+esp_err_t esp_lcd_panel_rm690b0_start_pipeline(const esp_lcd_panel_t* panel, const rm690b0_pipeline_config_t* config,
+                                               esp_lcd_panel_rm690b0_flush_done_cb_t done_cb, void* user_ctx) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+    Pipeline& pipeline = rm690b0->pipeline;
+    ESP_RETURN_ON_FALSE(!pipeline.task, ESP_ERR_INVALID_STATE, TAG, "pipeline already running");
 
-    // NOLINTEND(*-magic-numbers)
+    constexpr rm690b0_pipeline_config_t defaults = {.core_id = -1, .task_priority = 0, .queue_depth = 0};
+    const rm690b0_pipeline_config_t& cfg = config ? *config : defaults;
+    ESP_RETURN_ON_FALSE(cfg.core_id == -1 || cfg.core_id == tskNO_AFFINITY ||
+                        (cfg.core_id >= 0 && cfg.core_id < portNUM_PROCESSORS), ESP_ERR_INVALID_ARG, TAG,
+                        "no core %d", cfg.core_id);
 
-    // This command sequence (and the comments) is based on LilyGo's code by Lewis He:
-    // https://github.com/Xinyuan-LilyGO/LilyGo-Display-IDF/blob/master/main/initSequence.c,
+#if CONFIG_FREERTOS_UNICORE
+    const BaseType_t core_id = tskNO_AFFINITY;
+#else
+    const BaseType_t core_id = cfg.core_id == -1 ? (xPortGetCoreID() + 1) % portNUM_PROCESSORS : cfg.core_id;
+#endif
+    const UBaseType_t priority = cfg.task_priority ? cfg.task_priority : Pipeline::default_priority;
+    const size_t queue_depth = cfg.queue_depth ? cfg.queue_depth : Pipeline::default_queue_depth;
 
-    std::vector<LCDCmd> default_init_cmds() {
-        return {
-            {lcd_cmd_cmd_mode_switch, {0x20}}, // CMD Mode Switch: Manufacture Command Set Page Panel
-
-            // The 0x2400 and 0x5B00 commands  came from the LilyGo code.
-            // I cannot find mention of them in the RM9690B0 docs and don't know what they do.
-            // All I can say is that the display stays dark if I remove them, so here they stay.
-            {lcd_cmd_unknown_0x2400, {0x80}}, // SPI write RAM
-            {lcd_cmd_unknown_0x5B00, {0x2E}}, //! 230918:SWIRE FOR BV6804
-
-            {lcd_cmd_cmd_mode_switch, {0x00}}, // CMD Mode Switch: User Command Set (UCS = CMD1)
-            {lcd_cmd_set_disp_mode, {0x00}}, // set_DISP Mode: internal timing
-            {LCD_CMD_TEON, {0x00}}, // Tearing effect pin on
-            {LCD_CMD_SLPOUT, {}}, // Sleep out
-            {LCD_CMD_DISPON, {}}, // Display on
-        };
-    }
+    // Buffers only come back through the IO's transfer-done events
+    ESP_RETURN_ON_ERROR(claim_io_callbacks(panel), TAG, "Failed to claim panel IO callbacks"); // NOLINT
 
-    esp_err_t send_command(const esp_lcd_panel_t* panel, const LCDCmd& cmd) {
-        const RM690B0Panel* rm690b0 = panel_cast(panel);
+    pipeline.done_cb = done_cb;
+    pipeline.user_ctx = user_ctx;
 
-        if (cmd.param.size() == 1) {
-            ESP_LOGD(TAG, "Sending command %#010x with parameter 0x%x", cmd.lcd_cmd, cmd.param.at(0));
-        } else {
-            ESP_LOGD(TAG, "Sending command %#010x with %zu parameters", cmd.lcd_cmd, cmd.param.size());
-        }
+    pipeline.jobs = xQueueCreate(queue_depth, sizeof(FlushJob));
+    pipeline.stopped = xSemaphoreCreateBinary();
 
-        const esp_err_t ret = rm690b0->io->tx_param(rm690b0->io, cmd.lcd_cmd, cmd.param.data(), cmd.param.size());
+    if (pipeline.jobs && pipeline.stopped &&
+        xTaskCreatePinnedToCore(run_pipeline, "rm690b0_flush", Pipeline::stack_size, rm690b0, priority,
+                                &pipeline.task, core_id) == pdPASS) {
+        return ESP_OK;
+    }
 
-        std::this_thread::sleep_for(cmd.delay);
-        return ret;
+    if (pipeline.jobs) {
+        vQueueDelete(pipeline.jobs);
     }
 
-    esp_err_t send_command(const esp_lcd_panel_t* panel, const uint8_t command_addr,
-                           const std::vector<uint8_t>& param = {}) {
-        const LCDCmd cmd(command_addr, param);
-        return send_command(panel, cmd);
+    if (pipeline.stopped) {
+        vSemaphoreDelete(pipeline.stopped);
     }
 
-    esp_err_t send_commands(const esp_lcd_panel_t* panel, const std::vector<LCDCmd>& cmds) {
-        for (const auto& cmd : cmds) {
-            ESP_RETURN_ON_ERROR((send_command(panel, cmd)), TAG, "send command failed"); // NOLINT
-        }
+    pipeline = {};
+    ESP_LOGE(TAG, "Failed to create the transfer task");
+    return ESP_ERR_NO_MEM;
+}
 
-        return ESP_OK;
-    }
+esp_err_t esp_lcd_panel_rm690b0_flush_async(const esp_lcd_panel_t* panel, int x_start, int y_start, int x_end,
+                                            int y_end, const void* color_data) {
+    ESP_RETURN_ON_FALSE(panel && color_data, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    const Pipeline& pipeline = panel_cast(panel)->pipeline;
+    ESP_RETURN_ON_FALSE(pipeline.task, ESP_ERR_INVALID_STATE, TAG, "pipeline not running");
+    ESP_RETURN_ON_FALSE(valid_draw_area(panel, {x_start, y_start, x_end, y_end}), ESP_ERR_INVALID_ARG, TAG,
+                        "invalid draw area %d,%d-%d,%d", x_start, y_start, x_end, y_end);
 
-    // NOLINTBEGIN(*-magic-numbers)
-    uint8_t get_pixel_format(const esp_lcd_panel_t* panel) {
-        const RM690B0Panel* rm690b0 = panel_cast(panel);
+    const FlushJob job = {
+        .rect = {x_start, y_start, x_end, y_end},
+        .data = color_data,
+    };
 
-        if (rm690b0->grayscale && rm690b0->bits_per_pixel != 8) {
-            ESP_LOGE(TAG, "Grayscale is only supported with 8 bits per pixel");
-            return 0;
-        }
+    xQueueSend(pipeline.jobs, &job, portMAX_DELAY);
+    return ESP_OK;
+}
 
-        switch (rm690b0->bits_per_pixel) {
-        case 3:
-            return color_3_bits_per_pixel;
+esp_err_t esp_lcd_panel_rm690b0_stop_pipeline(const esp_lcd_panel_t* panel) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    ESP_RETURN_ON_FALSE(panel_cast(panel)->pipeline.task, ESP_ERR_INVALID_STATE, TAG, "pipeline not running");
 
-        case 8:
-            return rm690b0->grayscale ? grayscale_8_bits_per_pixel : color_8_bits_per_pixel;
+    stop_pipeline(panel);
+    return ESP_OK;
+}
 
-        case 16:
-            return color_16_bits_per_pixel;
+esp_err_t esp_lcd_panel_rm690b0_draw_bitmap_timeout(esp_lcd_panel_t* panel, int x_start, int y_start, int x_end,
+                                                    int y_end, const void* color_data, uint32_t timeout_ms) {
+    ESP_RETURN_ON_FALSE(panel && color_data, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_ERROR(init_backpressure(panel), TAG, "Failed to set up transfer counting"); // NOLINT
 
-        case 18:
-            return color_18_bits_per_pixel;
+    const int64_t deadline_us = esp_timer_get_time() + static_cast<int64_t>(timeout_ms) * 1000; // NOLINT
+    Rect rect = {x_start, y_start, x_end, y_end};
+    const auto* data = static_cast<const uint8_t*>(color_data);
+    ESP_RETURN_ON_FALSE(valid_draw_area(panel, rect), ESP_ERR_INVALID_ARG, TAG, "invalid draw area %d,%d-%d,%d",
+                        x_start, y_start, x_end, y_end);
 
-        case 24:
-            return color_24_bits_per_pixel;
+    if (!clip_to_partial_area(panel, rect, data)) {
+        return skip_draw(panel);
+    }
 
-        default:
-            return 0;
-        }
+    if (!claim_drained_bus_until(panel, deadline_us)) {
+        return ESP_ERR_TIMEOUT;
     }
 
-    // NOLINTEND(*-magic-numbers)
+    start_flush(panel);
+    const esp_err_t ret = draw_pixels(panel, rect, data);
+    end_flush(panel, ret);
 
-    // Returns the controller's code for the rotation set up by the user.
-    // Note that not all combinations seem to be supported by the RM690B0.
-    // If the user tries to mirror both x and y, at the same time, we return a "similar" code known to work.
+    return ret;
+}
 
-    // 0x60 = 0b01100000 swap xy + mirror y (rotate 90)
-    // 0x50 = 0b01010000 display goes wonky
-    // 0x40 = 0b01000000 display goes wonky
-    // 0x30 = 0b00110000 swap xy + mirror x (rotate -90)
-    // 0x20 = 0b00100000 swap xy
-    // 0x10 = 0b00010000 mirror y
-    // 0x00 = 0b00000000 default
-    uint8_t get_scan_direction(const esp_lcd_panel_t* panel) {
-        const RM690B0Panel* rm690b0 = panel_cast(panel);
+size_t esp_lcd_panel_rm690b0_get_in_flight_bytes(const esp_lcd_panel_t* panel) {
+    const ColorTransfers& transfers = panel_cast(panel)->transfers;
 
-        uint8_t rotation = rotation_normal;
+    // Read completed first: if the ISR passes in between, the result errs on the high side
+    const uint32_t completed = transfers.completed_bytes;
+    return transfers.submitted_bytes - completed;
+}
 
-        if (rm690b0->swap_xy) {
-            if (rm690b0->mirror_x) {
-                rotation = rotation_minus90;
-            } else if (rm690b0->mirror_y) {
-                rotation = rotation_plus90;
-            } else {
-                rotation = rotation_swap_xy;
-            }
-        } else if (rm690b0->mirror_y) {
-            rotation = rotation_mirror_y;
-        }
+esp_err_t esp_lcd_panel_rm690b0_draw_prepared(esp_lcd_panel_t* panel, const rm690b0_prepared_draw_t* draw,
+                                              const void* color_data) {
+    ESP_RETURN_ON_FALSE(panel && draw && color_data, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
 
-        return rotation;
-    }
+    const RM690B0Panel* rm690b0 = panel_cast(panel);
+    const auto* data = static_cast<const uint8_t*>(color_data);
 
-    esp_err_t update_screen_orientation(const esp_lcd_panel_t* panel) {
-        const RM690B0Panel* rm690b0 = panel_cast(panel);
+    // The window was computed for a color depth and gaps, which the panel must still have
+    ESP_RETURN_ON_FALSE(draw->bits_per_pixel == rm690b0->bits_per_pixel && draw->x_gap == rm690b0->x_gap &&
+                        draw->y_gap == rm690b0->y_gap, ESP_ERR_INVALID_STATE, TAG,
+                        "panel no longer has the prepared color depth or gaps");
 
-        uint8_t param = get_scan_direction(panel);
-        const uint8_t element_order = rm690b0->rgb_ele_order == LCD_RGB_ELEMENT_ORDER_RGB
-                                          ? rbg_element_order_rgb
-                                          : rbg_element_order_bgr;
-        param |= element_order;
-        ESP_LOGD(TAG, "Applying rotation code: 0x%x", param); // NOLINT
+    // A window that is empty or inside out, or pixels that don't fill it, would be sent as is
+    ESP_RETURN_ON_FALSE(draw->x_start <= draw->x_end && draw->y_start <= draw->y_end && draw->x_start >= draw->x_gap &&
+                        draw->y_start >= draw->y_gap, ESP_ERR_INVALID_ARG, TAG, "invalid prepared window");
+    const size_t pixels = static_cast<size_t>(draw->x_end - draw->x_start + 1) * (draw->y_end - draw->y_start + 1);
+    ESP_RETURN_ON_FALSE(draw->size == color_bytes(panel, pixels), ESP_ERR_INVALID_ARG, TAG,
+                        "prepared size %zu doesn't match the window's %zu bytes", draw->size,
+                        color_bytes(panel, pixels));
 
-        return send_command(panel, LCD_CMD_MADCTL, {param});
+    if (!plain_draw(panel, data)) {
+        return draw_bitmap(panel, draw->x_start - draw->x_gap, draw->y_start - draw->y_gap,
+                           draw->x_end - draw->x_gap + 1, draw->y_end - draw->y_gap + 1, color_data);
     }
 
-    // ReSharper restore CppRedundantZeroInitializerInAggregateInitialization
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    esp_err_t init(esp_lcd_panel_t* panel) {
-        const RM690B0Panel* rm690b0 = panel_cast(panel);
+    begin_flush(panel);
+    const esp_err_t ret = draw_prepared(panel, *draw, data);
+    end_flush(panel, ret);
 
-        // Power up the AMOLED controller
-        if (rm690b0->en_gpio_num != GPIO_NUM_NC) {
-            gpio_set_level(rm690b0->en_gpio_num, HIGH);
-            // The RM690B0 controller needs time to wake up before it can process commands
-            using namespace std::literals;
-            std::this_thread::sleep_for(25ms);
-        }
+    return ret;
+}
 
-        // Send initialization commands
-        ESP_RETURN_ON_ERROR(send_commands(panel, default_init_cmds()), TAG, // NOLINT
-                            "Failed to send init commands to display");
+esp_err_t esp_lcd_panel_rm690b0_test_link(esp_lcd_panel_t* panel, unsigned rounds, size_t* bad_bytes) {
+    ESP_RETURN_ON_FALSE(panel && bad_bytes, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
 
-        // Set up the image
-        update_screen_orientation(panel);
+    return test_link(panel, rounds, *bad_bytes);
+}
 
-        const uint8_t pixel_format = get_pixel_format(panel);
-        if (!pixel_format) {
-            ESP_LOGE(TAG, "Unsupported pixel format setting: %d bits per pixel, grayscale: %d",
-                     rm690b0->bits_per_pixel,
-                     rm690b0->grayscale);
-            return ESP_ERR_INVALID_ARG;
-        }
+esp_err_t esp_lcd_panel_rm690b0_calibrate_clock(const rm690b0_clock_calibration_t* config, uint32_t* clock_hz) {
+    ESP_RETURN_ON_FALSE(config && clock_hz, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->open_panel && config->close_panel, ESP_ERR_INVALID_ARG, TAG,
+                        "open_panel and close_panel must be set");
+    ESP_RETURN_ON_FALSE(config->min_clock_hz && config->step_hz && config->rounds &&
+                        config->min_clock_hz <= config->max_clock_hz, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid clock range");
 
-        ESP_RETURN_ON_ERROR(send_command(panel, LCD_CMD_COLMOD, {pixel_format}), // NOLINT
-                            TAG, "Error setting display brightness");
+    // If even the lowest clock fails, the readback itself can't be trusted, e.g. the panel returns
+    // pixels in another format, so there is nothing to calibrate against
+    ESP_RETURN_ON_FALSE(link_works(*config, config->min_clock_hz), ESP_ERR_INVALID_RESPONSE, TAG,
+                        "test patterns don't read back at %" PRIu32 " Hz", config->min_clock_hz);
 
-        if (rm690b0->bits_per_pixel == 16) { // NOLINT(*-magic-numbers)
-            static constexpr uint32_t swap_rgb565_bytes = 0b00010000;
-            send_command(panel, lcd_cmd_interface_pixel_format_option, {swap_rgb565_bytes});
-        }
+    // Stop at the first failure: a clock above one that glitches is no safer for passing once. best_hz never
+    // passes max_clock_hz, so the headroom can't wrap around, even with a step wider than the range.
+    uint32_t best_hz = config->min_clock_hz;
+    while (config->max_clock_hz - best_hz >= config->step_hz && link_works(*config, best_hz + config->step_hz)) {
+        best_hz += config->step_hz;
+    }
 
-        ESP_RETURN_ON_ERROR(esp_lcd_panel_rm690b0_set_brightness(panel, 0xFF), TAG, // NOLINT
-                            "Error setting display brightness");
+    ESP_LOGI(TAG, "Highest reliable clock: %" PRIu32 " Hz", best_hz);
+    *clock_hz = best_hz;
 
+    if (!config->nvs_namespace) {
         return ESP_OK;
     }
 
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    esp_err_t reset(esp_lcd_panel_t* panel) {
-        using namespace std::literals;
-        const RM690B0Panel* rm690b0 = panel_cast(panel);
-
-        static constexpr auto delay = 300ms;
+    nvs_handle_t nvs = 0;
+    ESP_RETURN_ON_ERROR(nvs_open(config->nvs_namespace, NVS_READWRITE, &nvs), TAG, // NOLINT
+                        "Failed to open NVS namespace %s", config->nvs_namespace);
 
-        gpio_set_level(rm690b0->reset_gpio_num, HIGH);
-        std::this_thread::sleep_for(delay);
-        gpio_set_level(rm690b0->reset_gpio_num, LOW);
-        std::this_thread::sleep_for(delay);
-        gpio_set_level(rm690b0->reset_gpio_num, HIGH);
-        std::this_thread::sleep_for(delay);
-
-        return ESP_OK;
+    esp_err_t ret = nvs_set_u32(nvs, clock_nvs_key, best_hz);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs);
     }
 
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    // ReSharper disable CppParameterMayBeConst
-    esp_err_t draw_bitmap(esp_lcd_panel_t* panel, int x_start, int y_start, int x_end, int y_end,
-                          const void* color_data) {
-        const RM690B0Panel* rm690b0 = panel_cast(panel);
-        const esp_lcd_panel_io_handle_t io = rm690b0->io; // NOLINT(*-misplaced-const)
+    nvs_close(nvs);
+    ESP_RETURN_ON_ERROR(ret, TAG, "Failed to store the clock"); // NOLINT
 
-        // Set the drawing window
-        //
-        // The -1 adjustment to x_end and y_end is needed because the esp_lcd API
-        // says the drawing windows *excludes* x_end and y_end, but the RM690B0 chip
-        // expects they are included.
+    return ESP_OK;
+}
 
-        x_start += rm690b0->x_gap;
-        x_end += rm690b0->x_gap - 1;
+esp_err_t esp_lcd_panel_rm690b0_load_clock(const char* nvs_namespace, uint32_t* clock_hz) {
+    ESP_RETURN_ON_FALSE(nvs_namespace && clock_hz, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
 
-        y_start += rm690b0->y_gap;
-        y_end += rm690b0->y_gap - 1;
+    nvs_handle_t nvs = 0;
+    esp_err_t ret = nvs_open(nvs_namespace, NVS_READONLY, &nvs);
+    if (ret != ESP_OK) {
+        return ret; // ESP_ERR_NVS_NOT_FOUND until a calibration created the namespace
+    }
 
-        const std::vector<LCDCmd> cmds = {
-            {
-                LCD_CMD_CASET,
-                {
-                    static_cast<uint8_t>(x_start >> 8 & 0xFF),
-                    static_cast<uint8_t>(x_start & 0xFF),
-                    static_cast<uint8_t>(x_end >> 8 & 0xFF),
-                    static_cast<uint8_t>(x_end & 0xFF)
-                }
-            },
-            {
-                LCD_CMD_RASET,
-                {
-                    static_cast<uint8_t>(y_start >> 8 & 0xFF),
-                    static_cast<uint8_t>(y_start & 0xFF),
-                    static_cast<uint8_t>(y_end >> 8 & 0xFF),
-                    static_cast<uint8_t>(y_end & 0xFF)
-                }
-            },
-            {
-                LCD_CMD_RAMWR,
-                {}
-            }
-        };
+    ret = nvs_get_u32(nvs, clock_nvs_key, clock_hz);
+    nvs_close(nvs);
+
+    return ret;
+}
 
-        ESP_RETURN_ON_ERROR(send_commands(panel, cmds), TAG, "set window commands failed"); // NOLINT
+esp_err_t esp_lcd_panel_rm690b0_read_area(const esp_lcd_panel_t* panel, int x_start, int y_start, int x_end,
+                                          int y_end, void* buffer, size_t buffer_size) {
+    ESP_RETURN_ON_FALSE(panel && buffer, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(x_start < x_end && y_start < y_end, ESP_ERR_INVALID_ARG, TAG, "empty area");
 
-        // Send color data
-        const size_t area_size = (x_end - x_start + 1) * (y_end - y_start + 1);
-        constexpr int lcd_cmd = pixel_prefix + (LCD_CMD_RAMWR << 8);
-        static constexpr uint8_t bits_per_byte = 8;
-        return io->tx_color(io, lcd_cmd, color_data, area_size * rm690b0->bits_per_pixel / bits_per_byte);
-    }
+    const Rect rect = {x_start, y_start, x_end, y_end};
+    ESP_RETURN_ON_FALSE(buffer_size >= color_bytes(panel, rect.area()), ESP_ERR_INVALID_SIZE, TAG,
+                        "buffer too small for %zu bytes", color_bytes(panel, rect.area()));
 
-    esp_err_t reset(gpio_num_t pin_num, const char* pin_name) {
-        if (pin_num == GPIO_NUM_NC) {
-            return ESP_OK;
-        }
+    // Reads wait for draws, and for their transfers: RAMRD must not overtake pixels still on the wire
+    claim_bus(panel);
+    const int64_t start = esp_timer_get_time();
+    const esp_err_t ret = read_window(panel, rect, static_cast<uint8_t*>(buffer));
+    const int64_t elapsed = esp_timer_get_time() - start;
+    release_bus(panel);
 
-        const esp_err_t ret = gpio_reset_pin(pin_num);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to reset %s pin: %d", pin_name, ret);
-        } else {
-            ESP_LOGD(TAG, "%s pin reset", pin_name);
-        }
+    if (ret == ESP_OK) {
+        Stats& stats = panel_cast(panel)->stats;
 
-        return ret;
+        portENTER_CRITICAL(&stats.lock);
+        stats.totals.readback_bytes += color_bytes(panel, rect.area());
+        stats.totals.readback_time_us += elapsed;
+        portEXIT_CRITICAL(&stats.lock);
     }
 
-    void reset_all_pins(const esp_lcd_panel_t* panel) {
-        const RM690B0Panel* rm690b0 = panel_cast(panel);
+    return ret;
+}
 
-        reset(rm690b0->reset_gpio_num, "RESET");
-        reset(rm690b0->en_gpio_num, "EN");
-    }
+esp_err_t esp_lcd_panel_rm690b0_fill_rect(const esp_lcd_panel_t* panel, int x_start, int y_start, int x_end,
+                                          int y_end, uint32_t color) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
+    ESP_RETURN_ON_FALSE(x_start < x_end && y_start < y_end, ESP_ERR_INVALID_ARG, TAG, "empty area");
+    ESP_RETURN_ON_FALSE(bytes_per_pixel(panel), ESP_ERR_NOT_SUPPORTED, TAG,
+                        "fills need a whole number of bytes per pixel");
+    ESP_RETURN_ON_ERROR(init_fill(panel), TAG, "Failed to set up fill buffer"); // NOLINT
+    RM690B0Panel* rm690b0 = panel_cast(panel);
 
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    esp_err_t del(esp_lcd_panel_t* panel) {
-        const std::unique_ptr<RM690B0Panel> owner(panel_cast(panel));
+    // The color as draw_bitmap would find it in memory
+    // NOLINTBEGIN(*-magic-numbers)
+    std::array<uint8_t, 3> pixel{};
+    switch (bytes_per_pixel(panel)) {
+    case 1:
+        pixel = {static_cast<uint8_t>(color)};
+        break;
 
-        reset_all_pins(panel);
-        return ESP_OK;
+    case 2:
+        pixel = {static_cast<uint8_t>(color), static_cast<uint8_t>(color >> 8)};
+        break;
+
+    default:
+        pixel = {static_cast<uint8_t>(color >> 16), static_cast<uint8_t>(color >> 8), static_cast<uint8_t>(color)};
+        break;
     }
+    // NOLINTEND(*-magic-numbers)
 
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    esp_err_t invert_color(esp_lcd_panel_t* panel, bool invert_color_data) {
-        return send_command(panel, invert_color_data ? LCD_CMD_INVON : LCD_CMD_INVOFF);
+    Rect rect = {x_start, y_start, x_end, y_end};
+    if (!clip_rows_to_partial_area(panel, rect)) {
+        return skip_draw(panel);
     }
 
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    esp_err_t swap_xy(esp_lcd_panel_t* panel, bool swap_axes) {
-        RM690B0Panel* rm690b0 = panel_cast(panel);
+    begin_flush(panel);
+    const esp_err_t ret = fill_window(panel, rect, pixel.data(), rm690b0->te.sync, transfer_end_of_draw);
+    end_flush(panel, ret);
 
-        rm690b0->swap_xy = swap_axes;
-        return update_screen_orientation(panel);
-    }
+    return ret;
+}
 
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    esp_err_t mirror(esp_lcd_panel_t* panel, bool mirror_x, bool mirror_y) {
-        RM690B0Panel* rm690b0 = panel_cast(panel);
-        rm690b0->mirror_x = mirror_x;
-        rm690b0->mirror_y = mirror_y;
+esp_err_t esp_lcd_panel_rm690b0_set_fill_detection(const esp_lcd_panel_t* panel, bool enable) {
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "panel must not be null");
 
-        return update_screen_orientation(panel);
+    if (enable) {
+        ESP_RETURN_ON_FALSE(bytes_per_pixel(panel), ESP_ERR_NOT_SUPPORTED, TAG,
+                            "fill detection needs a whole number of bytes per pixel");
+        ESP_RETURN_ON_ERROR(init_fill(panel), TAG, "Failed to set up fill buffer"); // NOLINT
     }
 
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    esp_err_t set_gap(esp_lcd_panel_t* panel, int x_gap, int y_gap) {
-        RM690B0Panel* rm690b0 = panel_cast(panel);
-
-        rm690b0->x_gap = x_gap;
-        rm690b0->y_gap = y_gap;
+    panel_cast(panel)->fill.detect = enable;
+    return ESP_OK;
+}
 
-        return ESP_OK;
-    }
+esp_err_t esp_lcd_panel_rm690b0_create_framebuffers(const esp_lcd_panel_t* panel,
+                                                   const rm690b0_framebuffer_config_t* config) {
+    ESP_RETURN_ON_FALSE(panel && config, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->width > 0 && config->height > 0, ESP_ERR_INVALID_ARG, TAG, "invalid size");
+    ESP_RETURN_ON_FALSE(config->num_fbs >= 1 && config->num_fbs <= Framebuffers::max_count, ESP_ERR_INVALID_ARG, TAG,
+                        "1 to %zu framebuffers", Framebuffers::max_count);
+    RM690B0Panel* rm690b0 = panel_cast(panel);
+    Framebuffers& framebuffers = rm690b0->framebuffers;
+    ESP_RETURN_ON_FALSE(!framebuffers.count, ESP_ERR_INVALID_STATE, TAG, "framebuffers already created");
+    ESP_RETURN_ON_FALSE(config->direct_dma || rm690b0->streaming.buffer_size, ESP_ERR_INVALID_STATE, TAG,
+                        "framebuffers without direct DMA need streaming buffers");
 
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    esp_err_t disp_on_off(esp_lcd_panel_t* panel, bool on_off) {
-        const uint8_t command_code = on_off ? LCD_CMD_DISPON : LCD_CMD_DISPOFF;
-        return send_command(panel, command_code);
-    }
+    // Transfer-done events tell the caller when a framebuffer is free again
+    ESP_RETURN_ON_ERROR(claim_io_callbacks(panel), TAG, "Failed to claim panel IO callbacks"); // NOLINT
 
-    // ReSharper disable once CppParameterMayBeConstPtrOrRef
-    esp_err_t sleep(esp_lcd_panel_t* panel, bool sleep) {
-        const uint8_t command_code = sleep ? LCD_CMD_SLPIN : LCD_CMD_SLPOUT;
-        return send_command(panel, command_code);
-    }
+    size_t alignment = 0;
+    ESP_RETURN_ON_ERROR(esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &alignment), TAG, // NOLINT
+                        "Failed to get PSRAM cache line size");
+    alignment = std::max<size_t>(alignment, 4);
 
+    const size_t size = color_bytes(panel, static_cast<size_t>(config->width) * config->height);
+    const size_t aligned_size = (size + alignment - 1) / alignment * alignment;
 
-    // Initialize a GPIO pin for output.
-    // If this operation fails, *all* output pins are reset.
-    esp_err_t init_out_pin(const esp_lcd_panel_t* panel, gpio_num_t pin, const char* pin_name) {
-        if (pin == GPIO_NUM_NC) {
-            return ESP_OK;
-        }
+    std::array<DmaBuffer, Framebuffers::max_count> buffers;
+    for (size_t i = 0; i < config->num_fbs; ++i) {
+        buffers.at(i).reset(static_cast<uint8_t*>(heap_caps_aligned_calloc(alignment, 1, aligned_size,
+                                                                           MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)));
+        ESP_RETURN_ON_FALSE(buffers.at(i), ESP_ERR_NO_MEM, TAG, "no memory for framebuffer %zu", i);
+    }
 
-        const gpio_config_t io_conf = {
-            .pin_bit_mask = 1ULL << pin,
-            .mode = GPIO_MODE_OUTPUT,
-        };
+    framebuffers.buffers = std::move(buffers);
+    framebuffers.width = config->width;
+    framebuffers.height = config->height;
+    framebuffers.direct_dma = config->direct_dma;
+    framebuffers.count = config->num_fbs;
 
-        ESP_LOGD(TAG, "Configuring %s pin (GPIO %d) as output", pin_name, pin);
-        const esp_err_t ret = gpio_config(&io_conf);
+    ESP_LOGD(TAG, "%zu framebuffers of %zu bytes in PSRAM", framebuffers.count, aligned_size);
+    return ESP_OK;
+}
 
-        if (ret != ESP_OK) {
-            reset_all_pins(panel);
-        }
+esp_err_t esp_lcd_panel_rm690b0_get_framebuffer(const esp_lcd_panel_t* panel, size_t index, void** framebuffer) {
+    ESP_RETURN_ON_FALSE(panel && framebuffer, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    const Framebuffers& framebuffers = panel_cast(panel)->framebuffers;
+    ESP_RETURN_ON_FALSE(index < framebuffers.count, ESP_ERR_INVALID_ARG, TAG, "no framebuffer %zu", index);
 
-        return ret;
-    }
+    *framebuffer = framebuffers.buffers.at(index).get();
+    return ESP_OK;
 }
 
-uint8_t esp_lcd_panel_rm690b0_get_brightness(const esp_lcd_panel_t* panel) {
+esp_err_t esp_lcd_panel_rm690b0_get_panel_info(const esp_lcd_panel_t* panel, rm690b0_panel_info_t* info) {
+    ESP_RETURN_ON_FALSE(panel && info, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
     const RM690B0Panel* rm690b0 = panel_cast(panel);
-    return rm690b0->brightness;
-}
 
-esp_err_t esp_lcd_panel_rm690b0_set_brightness(const esp_lcd_panel_t* panel, uint8_t brightness) {
-    RM690B0Panel* rm690b0 = panel_cast(panel);
-    rm690b0->brightness = brightness;
+    *info = {
+        .width = rm690b0->swap_xy ? rm690b0->height : rm690b0->width,
+        .height = rm690b0->swap_xy ? rm690b0->width : rm690b0->height,
+        .bits_per_pixel = rm690b0->bits_per_pixel,
+        .grayscale = rm690b0->grayscale,
+        .stream_buffer_size = rm690b0->streaming.buffer_size,
+        .num_fbs = rm690b0->framebuffers.count,
+        .fb_width = rm690b0->framebuffers.width,
+        .fb_height = rm690b0->framebuffers.height,
+    };
 
-    return send_command(panel, lcd_cmd_write_display_brightness, {brightness});
+    return ESP_OK;
 }
 
 esp_err_t esp_lcd_new_panel_rm690b0(esp_lcd_panel_io_handle_t io, // NOLINT(*-misplaced-const)
@@ -512,6 +4385,30 @@ esp_err_t esp_lcd_new_panel_rm690b0(esp_lcd_panel_io_handle_t io, // NOLINT(*-mi
         }
 
         rm690b0->grayscale = rm690b0_vendor->grayscale;
+
+        ESP_RETURN_ON_FALSE(rm690b0_vendor->width >= 0 && rm690b0_vendor->height >= 0, ESP_ERR_INVALID_ARG, TAG,
+                            "invalid panel size");
+        rm690b0->width = rm690b0_vendor->width;
+        rm690b0->height = rm690b0_vendor->height;
+
+        ESP_RETURN_ON_FALSE(static_cast<size_t>(rm690b0_vendor->bus) < bus_backends.size(), ESP_ERR_INVALID_ARG,
+                            TAG, "unknown bus %d", rm690b0_vendor->bus);
+        rm690b0->backend = &bus_backends.at(rm690b0_vendor->bus);
+
+        if (rm690b0_vendor->init_cmds) {
+            ESP_RETURN_ON_FALSE(rm690b0_vendor->init_cmds_size, ESP_ERR_INVALID_ARG, TAG, "empty init_cmds");
+            rm690b0->init_cmds = {rm690b0_vendor->init_cmds, rm690b0_vendor->init_cmds_size};
+
+            for (const rm690b0_lcd_init_cmd_t& cmd : rm690b0->init_cmds) {
+                ESP_RETURN_ON_FALSE(cmd.data || !cmd.data_bytes, ESP_ERR_INVALID_ARG, TAG,
+                                    "init command %#04x has %zu parameter bytes but no data", cmd.cmd, cmd.data_bytes);
+            }
+        }
+
+        if (rm690b0_vendor->use_te) {
+            rm690b0->te.gpio_num = rm690b0_vendor->te_gpio_num;
+            rm690b0->te.sync = rm690b0_vendor->te_sync;
+        }
     }
 
     // Initialize gpio pins
@@ -519,6 +4416,27 @@ esp_err_t esp_lcd_new_panel_rm690b0(esp_lcd_panel_io_handle_t io, // NOLINT(*-mi
     // IMPORTANT: If you add a new pin to this section, you must also add the pin to be released in reset_all_pins()
     ESP_RETURN_ON_ERROR(init_out_pin(&rm690b0->base, rm690b0->reset_gpio_num, "RESET"), TAG, "Failed to init pin"); // NOLINT(*-const-correctness)
     ESP_RETURN_ON_ERROR(init_out_pin(&rm690b0->base, rm690b0->en_gpio_num, "EN"), TAG, "Failed to init pin"); // NOLINT(*-const-correctness)
+    ESP_RETURN_ON_ERROR(init_te_pin(&rm690b0->base), TAG, "Failed to init pin"); // NOLINT(*-const-correctness)
+
+    rm690b0->bus.released = xSemaphoreCreateBinary();
+    if (!rm690b0->bus.released) {
+        del(&rm690b0.release()->base);
+        ESP_LOGE(TAG, "no memory for bus semaphore");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (rm690b0_vendor) {
+        const esp_err_t ret = init_streaming(&rm690b0->base, rm690b0_vendor->stream_buffer_size);
+        if (ret != ESP_OK) {
+            del(&rm690b0.release()->base);
+            return ret;
+        }
+    }
+
+    if (const esp_err_t ret = alloc_fill(&rm690b0->base); ret != ESP_OK) {
+        del(&rm690b0.release()->base);
+        return ret;
+    }
 
     // All done
     // ReSharper disable once CppDFANullDereference
@@ -0,0 +1,263 @@
+// Host benchmark of the driver: what each operation costs in commands, bytes, allocations and CPU time,
+// against a mock panel IO. Exits with 1 if a draw, a fill or an orientation change allocates.
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <optional>
+
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_rm690b0.h"
+#include "host_idf.h"
+#include "mock_panel_io.h"
+
+namespace {
+    constexpr int width = 600;  // The LilyGo T4 S3's panel
+    constexpr int height = 450;
+    constexpr int bits_per_pixel = 16;
+    constexpr size_t frame_bytes = static_cast<size_t>(width) * height * bits_per_pixel / 8;
+    constexpr size_t stream_buffer_size = 32 * 1024;
+    constexpr int small_rect = 32;
+
+    // CPU cycles of the calling thread in user space, if the kernel lets us count them
+    class CycleCounter {
+    public:
+        CycleCounter() {
+            perf_event_attr attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        ~CycleCounter() {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        CycleCounter(const CycleCounter&) = delete;
+        CycleCounter& operator=(const CycleCounter&) = delete;
+
+        [[nodiscard]] std::optional<uint64_t> read() const {
+            uint64_t cycles = 0;
+            if (fd < 0 || ::read(fd, &cycles, sizeof(cycles)) != sizeof(cycles)) {
+                return std::nullopt;
+            }
+
+            return cycles;
+        }
+
+    private:
+        int fd = -1;
+    };
+
+    int64_t thread_cpu_ns() {
+        timespec now{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+        return now.tv_sec * 1'000'000'000 + now.tv_nsec;
+    }
+
+    struct Result {
+        double commands;
+        double param_bytes;
+        double transfers;
+        double color_bytes;
+        double allocations;
+        double cpu_ns;
+        std::optional<double> cycles;
+    };
+
+    // Run op `runs` times and average what it cost
+    template <typename Op>
+    Result measure(MockPanelIO& io, const CycleCounter& counter, const size_t runs, Op op) {
+        io.clear();
+        const host_idf::Allocations allocations = host_idf::allocations();
+        const std::optional<uint64_t> cycles = counter.read();
+        const int64_t cpu_ns = thread_cpu_ns();
+
+        for (size_t i = 0; i < runs; ++i) {
+            if (const esp_err_t ret = op(i); ret != ESP_OK) {
+                std::fprintf(stderr, "operation failed: %s\n", esp_err_to_name(ret));
+                std::exit(2);
+            }
+        }
+
+        const int64_t cpu_ns_after = thread_cpu_ns();
+        const std::optional<uint64_t> cycles_after = counter.read();
+        const auto per_run = [runs](const double total) { return total / static_cast<double>(runs); };
+
+        Result result = {
+            .commands = per_run(static_cast<double>(io.totals().commands)),
+            .param_bytes = per_run(static_cast<double>(io.totals().param_bytes)),
+            .transfers = per_run(static_cast<double>(io.totals().colors)),
+            .color_bytes = per_run(static_cast<double>(io.totals().color_bytes)),
+            .allocations = per_run(static_cast<double>(host_idf::allocations().count - allocations.count)),
+            .cpu_ns = per_run(static_cast<double>(cpu_ns_after - cpu_ns)),
+            .cycles = std::nullopt,
+        };
+
+        if (cycles && cycles_after) {
+            result.cycles = per_run(static_cast<double>(*cycles_after - *cycles));
+        }
+
+        return result;
+    }
+
+    void print_header() {
+        std::printf("%-28s %6s %8s %11s %9s %11s %9s %11s %11s\n", "operation", "runs", "cmds/op", "param B/op",
+                    "xfers/op", "color B/op", "allocs/op", "cpu ns/op", "cycles/op");
+    }
+
+    void print(const char* name, const size_t runs, const Result& result) {
+        std::array<char, 16> cycles{"-"};
+        if (result.cycles) {
+            std::snprintf(cycles.data(), cycles.size(), "%.0f", *result.cycles);
+        }
+
+        std::printf("%-28s %6zu %8.1f %11.1f %9.1f %11.1f %9.2f %11.0f %11s\n", name, runs, result.commands,
+                    result.param_bytes, result.transfers, result.color_bytes, result.allocations, result.cpu_ns,
+                    cycles.data());
+    }
+
+    // Pixels that differ, so fill detection never turns a draw into a fill
+    void fill_pattern(uint8_t* pixels, const size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            pixels[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+        }
+    }
+}
+
+int main() {
+    MockPanelIO io;
+    const CycleCounter counter;
+    bool allocates = false;
+
+    rm960b0_vendor_config_t vendor_config = {};
+    vendor_config.en_gpio_num = GPIO_NUM_NC;
+    vendor_config.stream_buffer_size = stream_buffer_size;
+    vendor_config.width = width;
+    vendor_config.height = height;
+
+    esp_lcd_panel_dev_config_t panel_config = {};
+    panel_config.reset_gpio_num = GPIO_NUM_NC;
+    panel_config.bits_per_pixel = bits_per_pixel;
+    panel_config.vendor_config = &vendor_config;
+
+    esp_lcd_panel_handle_t panel = nullptr;
+    if (esp_lcd_new_panel_rm690b0(io.handle(), &panel_config, &panel) != ESP_OK) {
+        std::fprintf(stderr, "panel creation failed\n");
+        return 2;
+    }
+
+    auto* internal = static_cast<uint8_t*>(heap_caps_malloc(frame_bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL));
+    auto* psram = static_cast<uint8_t*>(heap_caps_malloc(frame_bytes, MALLOC_CAP_SPIRAM));
+    fill_pattern(internal, frame_bytes);
+    fill_pattern(psram, frame_bytes);
+
+    print_header();
+
+    // Init, draws, fills and orientation changes must not allocate, whatever the source of the pixels
+    const auto check = [&allocates](const char* name, const size_t runs, const Result& result) {
+        print(name, runs, result);
+        if (result.allocations != 0) {
+            std::fprintf(stderr, "%s allocates\n", name);
+            allocates = true;
+        }
+    };
+
+    // Delays don't take real time: they move the simulated clock on
+    const auto reset_and_init = [](esp_lcd_panel_handle_t handle) {
+        const esp_err_t ret = esp_lcd_panel_reset(handle);
+        return ret != ESP_OK ? ret : esp_lcd_panel_init(handle);
+    };
+
+    check("reset + init", 10, measure(io, counter, 10, [&](size_t) { return reset_and_init(panel); }));
+
+    // A user table, with a command longer than the built-in ones, which goes out whole
+    static constexpr std::array<uint8_t, 8> long_params = {1, 2, 3, 4, 5, 6, 7, 8};
+    static constexpr std::array<rm690b0_lcd_init_cmd_t, 3> user_init_cmds = {{
+        {0x11, nullptr, 0, 120},
+        {0xFE, long_params.data(), long_params.size(), 0},
+        {0x29, nullptr, 0, 10},
+    }};
+
+    MockPanelIO user_io;
+    rm960b0_vendor_config_t user_vendor_config = vendor_config;
+    user_vendor_config.init_cmds = user_init_cmds.data();
+    user_vendor_config.init_cmds_size = user_init_cmds.size();
+    panel_config.vendor_config = &user_vendor_config;
+
+    esp_lcd_panel_handle_t user_panel = nullptr;
+    if (esp_lcd_new_panel_rm690b0(user_io.handle(), &panel_config, &user_panel) != ESP_OK) {
+        std::fprintf(stderr, "panel creation with an init table failed\n");
+        return 2;
+    }
+
+    check("reset + init, user table", 10,
+          measure(user_io, counter, 10, [&](size_t) { return reset_and_init(user_panel); }));
+    esp_lcd_panel_del(user_panel);
+
+    // Tables the driver can't send are refused up front
+    static constexpr std::array<rm690b0_lcd_init_cmd_t, 1> bad_init_cmds = {{{0xFE, nullptr, 4, 0}}};
+    user_vendor_config.init_cmds = bad_init_cmds.data();
+    user_vendor_config.init_cmds_size = bad_init_cmds.size();
+    if (esp_lcd_new_panel_rm690b0(user_io.handle(), &panel_config, &user_panel) != ESP_ERR_INVALID_ARG) {
+        std::fprintf(stderr, "init table without parameter data accepted\n");
+        return 1;
+    }
+
+    esp_lcd_panel_rm690b0_reset_stats(panel);
+
+    check("draw_bitmap full frame", 100, measure(io, counter, 100, [panel, internal](size_t) {
+              return esp_lcd_panel_draw_bitmap(panel, 0, 0, width, height, internal);
+          }));
+
+    check("draw_bitmap 32x32", 1000, measure(io, counter, 1000, [panel, internal](const size_t i) {
+              // Tiles across the screen, like the dirty areas of a UI
+              constexpr size_t columns = width / small_rect;
+              constexpr size_t rows = height / small_rect;
+              const int x = static_cast<int>(i % columns) * small_rect;
+              const int y = static_cast<int>(i / columns % rows) * small_rect;
+              return esp_lcd_panel_draw_bitmap(panel, x, y, x + small_rect, y + small_rect, internal);
+          }));
+
+    check("draw_bitmap full, streamed", 100, measure(io, counter, 100, [panel, psram](size_t) {
+              return esp_lcd_panel_draw_bitmap(panel, 0, 0, width, height, psram);
+          }));
+
+    rm690b0_stats_t stats = {};
+    esp_lcd_panel_rm690b0_get_stats(panel, &stats);
+
+    check("fill_rect full frame", 100, measure(io, counter, 100, [panel](const size_t i) {
+              return esp_lcd_panel_rm690b0_fill_rect(panel, 0, 0, width, height, static_cast<uint32_t>(i));
+          }));
+
+    // Rotate through the four orientations, ending where we started
+    check("swap_xy + mirror", 100, measure(io, counter, 100, [panel](const size_t i) {
+              const bool swap = i & 1;
+              const bool mirror = i & 2;
+              const esp_err_t ret = esp_lcd_panel_swap_xy(panel, swap);
+              return ret != ESP_OK ? ret : esp_lcd_panel_mirror(panel, mirror, mirror);
+          }));
+
+    std::array<char, 512> line{};
+    esp_lcd_panel_rm690b0_format_stats(&stats, line.data(), line.size());
+    std::printf("draw stats: %s\n", line.data());
+
+    esp_lcd_panel_del(panel);
+    heap_caps_free(internal);
+    heap_caps_free(psram);
+
+    return allocates ? 1 : 0;
+}
@@ -0,0 +1,417 @@
+// Host tests of the driver: what each feature sends to the panel, checked against the mock panel IO's call log.
+// Exits with 1 if any check fails.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <source_location>
+#include <thread>
+#include <vector>
+
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_rm690b0.h"
+#include "mock_panel_io.h"
+
+namespace {
+    constexpr int width = 600; // The LilyGo T4 S3's panel
+    constexpr int height = 450;
+    constexpr size_t stream_buffer_size = 32 * 1024;
+
+    constexpr uint8_t caset = 0x2A;
+    constexpr uint8_t raset = 0x2B;
+    constexpr uint8_t ramwr = 0x2C;
+    constexpr uint8_t invoff = 0x20;
+    constexpr uint8_t invon = 0x21;
+    constexpr uint8_t ptlar = 0x30;
+    constexpr uint8_t vscrdef = 0x33;
+    constexpr uint8_t madctl = 0x36;
+    constexpr uint8_t vscsad = 0x37;
+    constexpr uint8_t brightness = 0x51;
+
+    int failures = 0;
+
+    void expect(const bool ok, const char* what, const std::source_location where = std::source_location::current()) {
+        if (!ok) {
+            std::fprintf(stderr, "%s:%u: expected %s\n", where.file_name(), static_cast<unsigned>(where.line()), what);
+            ++failures;
+        }
+    }
+
+#define EXPECT(condition) expect((condition), #condition)
+
+    // A panel of the T4 S3's size on a mock panel IO, with streaming buffers so it can mirror in software
+    class TestPanel {
+    public:
+        explicit TestPanel(const int bits_per_pixel = 16) {
+            vendor_config.en_gpio_num = GPIO_NUM_NC;
+            vendor_config.stream_buffer_size = stream_buffer_size;
+            vendor_config.width = width;
+            vendor_config.height = height;
+
+            esp_lcd_panel_dev_config_t config = {};
+            config.reset_gpio_num = GPIO_NUM_NC;
+            config.bits_per_pixel = bits_per_pixel;
+            config.vendor_config = &vendor_config;
+
+            EXPECT(esp_lcd_new_panel_rm690b0(io.handle(), &config, &handle) == ESP_OK);
+            io.clear();
+        }
+
+        ~TestPanel() {
+            if (handle) {
+                esp_lcd_panel_del(handle);
+            }
+        }
+
+        TestPanel(const TestPanel&) = delete;
+        TestPanel& operator=(const TestPanel&) = delete;
+
+        MockPanelIO io;
+        esp_lcd_panel_handle_t handle = nullptr;
+
+    private:
+        rm960b0_vendor_config_t vendor_config = {};
+    };
+
+    // The commands sent to `command`, in order
+    std::vector<MockPanelIO::Call> commands(const MockPanelIO& io, const uint8_t command) {
+        std::vector<MockPanelIO::Call> found;
+        for (const MockPanelIO::Call& call : io.calls()) {
+            if (call.kind == MockPanelIO::Kind::param && call.command == command) {
+                found.push_back(call);
+            }
+        }
+
+        return found;
+    }
+
+    size_t color_transfers(const MockPanelIO& io) {
+        size_t count = 0;
+        for (const MockPanelIO::Call& call : io.calls()) {
+            count += call.kind == MockPanelIO::Kind::color;
+        }
+
+        return count;
+    }
+
+    // The 16-bit value at `index` of a command's parameters, e.g. the start and end of CASET
+    int param16(const MockPanelIO::Call& call, const size_t index) {
+        return call.param.at(index * 2) << 8 | call.param.at(index * 2 + 1);
+    }
+
+    // The test fails unless the last CASET and RASET set these windows, ends included
+    void expect_window(const MockPanelIO& io, const int x_first, const int x_last, const int y_first, const int y_last,
+                       const std::source_location where = std::source_location::current()) {
+        const std::vector<MockPanelIO::Call> columns = commands(io, caset);
+        const std::vector<MockPanelIO::Call> rows = commands(io, raset);
+        expect(!columns.empty() && !rows.empty(), "a window to be set", where);
+
+        if (!columns.empty() && !rows.empty()) {
+            expect(param16(columns.back(), 0) == x_first && param16(columns.back(), 1) == x_last, "CASET columns",
+                   where);
+            expect(param16(rows.back(), 0) == y_first && param16(rows.back(), 1) == y_last, "RASET rows", where);
+        }
+    }
+
+    std::vector<uint8_t> pattern(const size_t size) {
+        std::vector<uint8_t> pixels(size);
+        for (size_t i = 0; i < size; ++i) {
+            pixels[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+        }
+
+        return pixels;
+    }
+
+    void rejects_empty_and_off_panel_draws() {
+        TestPanel panel;
+        const std::vector<uint8_t> pixels = pattern(width * 2 * 20);
+        EXPECT(esp_lcd_panel_rm690b0_set_fill_detection(panel.handle, true) == ESP_OK);
+        panel.io.clear();
+
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 10, 10, 10, 20, pixels.data()) == ESP_ERR_INVALID_ARG);
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 10, 20, 20, 10, pixels.data()) == ESP_ERR_INVALID_ARG);
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, -1, 0, 10, 10, pixels.data()) == ESP_ERR_INVALID_ARG);
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 0, 0, width + 1, 10, pixels.data()) == ESP_ERR_INVALID_ARG);
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 0, 0, 10, 10, nullptr) == ESP_ERR_INVALID_ARG);
+        EXPECT(panel.io.call_count() == 0);
+    }
+
+    void window_cache_skips_address_commands() {
+        TestPanel panel;
+        const std::vector<uint8_t> pixels = pattern(32 * 32 * 2);
+
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 0, 0, 32, 32, pixels.data()) == ESP_OK);
+        expect_window(panel.io, 0, 31, 0, 31);
+
+        // Same window: only the pixels go out
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 0, 0, 32, 32, pixels.data()) == ESP_OK);
+        EXPECT(commands(panel.io, caset).empty() && commands(panel.io, raset).empty());
+        EXPECT(color_transfers(panel.io) == 1);
+
+        // Another window, or the same one moved by a new gap
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 32, 0, 64, 32, pixels.data()) == ESP_OK);
+        expect_window(panel.io, 32, 63, 0, 31);
+
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_set_gap(panel.handle, 16, 0) == ESP_OK);
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 32, 0, 64, 32, pixels.data()) == ESP_OK);
+        expect_window(panel.io, 48, 79, 0, 31);
+    }
+
+    void partial_mode_clips_draws() {
+        TestPanel panel;
+        const std::vector<uint8_t> pixels = pattern(4 * 200 * 2);
+
+        // Rows 100 to 149 shown
+        EXPECT(esp_lcd_panel_rm690b0_set_partial_mode(panel.handle, true, 100, 150) == ESP_OK);
+        const std::vector<MockPanelIO::Call> areas = commands(panel.io, ptlar);
+        EXPECT(areas.size() == 1 && param16(areas.front(), 0) == 100 && param16(areas.front(), 1) == 149);
+
+        // Only the shown rows of a draw across the area go out
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 0, 0, 4, 200, pixels.data()) == ESP_OK);
+        expect_window(panel.io, 0, 3, 100, 149);
+        EXPECT(panel.io.totals().color_bytes == 4 * 50 * 2);
+
+        // A draw outside the area sends nothing
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 0, 0, 4, 20, pixels.data()) == ESP_OK);
+        EXPECT(panel.io.call_count() == 0);
+    }
+
+    void mirror_and_swap_move_the_window() {
+        TestPanel panel;
+        const std::vector<uint8_t> pixels = pattern(30 * 10 * 2);
+
+        // The controller can't mirror x without swapping, so the driver moves the window across instead
+        EXPECT(esp_lcd_panel_mirror(panel.handle, true, false) == ESP_OK);
+        const std::vector<MockPanelIO::Call> orientations = commands(panel.io, madctl);
+        EXPECT(orientations.size() == 1 && orientations.front().param[0] == 0x00);
+
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 10, 20, 40, 30, pixels.data()) == ESP_OK);
+        expect_window(panel.io, width - 40, width - 11, 20, 29);
+
+        // Swapped and mirrored both ways: the controller rotates by -90°, the driver mirrors the rows
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_swap_xy(panel.handle, true) == ESP_OK);
+        EXPECT(esp_lcd_panel_mirror(panel.handle, true, true) == ESP_OK);
+        const std::vector<MockPanelIO::Call> rotated = commands(panel.io, madctl);
+        EXPECT(!rotated.empty() && rotated.back().param[0] == 0x30);
+
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 10, 20, 40, 30, pixels.data()) == ESP_OK);
+        expect_window(panel.io, 10, 39, width - 30, width - 21);
+    }
+
+    void scroll_start_follows_mirror() {
+        TestPanel panel;
+
+        // 10 fixed lines, 400 scrolling, 40 fixed, scrolled by 5
+        EXPECT(esp_lcd_panel_rm690b0_set_scroll_area(panel.handle, 10, 400, 40) == ESP_OK);
+        EXPECT(esp_lcd_panel_rm690b0_scroll_to(panel.handle, 5) == ESP_OK);
+        std::vector<MockPanelIO::Call> starts = commands(panel.io, vscsad);
+        EXPECT(!starts.empty() && param16(starts.back(), 0) == 10 + 5);
+
+        // Mirroring y reverses the controller's lines: the fixed areas swap ends, and the offset counts back
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_mirror(panel.handle, false, true) == ESP_OK);
+        const std::vector<MockPanelIO::Call> areas = commands(panel.io, vscrdef);
+        EXPECT(areas.size() == 1 && param16(areas.front(), 0) == 40 && param16(areas.front(), 1) == 400 &&
+               param16(areas.front(), 2) == 10);
+        starts = commands(panel.io, vscsad);
+        EXPECT(!starts.empty() && param16(starts.back(), 0) == 40 + 400 - 5);
+    }
+
+    void cmd_batch_folds_register_writes() {
+        TestPanel panel;
+        const std::vector<uint8_t> pixels = pattern(2 * 2 * 2);
+
+        EXPECT(esp_lcd_panel_rm690b0_cmd_batch_begin(panel.handle) == ESP_OK);
+        EXPECT(esp_lcd_panel_swap_xy(panel.handle, true) == ESP_OK);
+        EXPECT(esp_lcd_panel_mirror(panel.handle, true, false) == ESP_OK);
+        EXPECT(esp_lcd_panel_rm690b0_set_brightness(panel.handle, 10) == ESP_OK);
+        EXPECT(esp_lcd_panel_rm690b0_set_brightness(panel.handle, 20) == ESP_OK);
+        EXPECT(esp_lcd_panel_invert_color(panel.handle, true) == ESP_OK);
+        EXPECT(esp_lcd_panel_invert_color(panel.handle, false) == ESP_OK);
+
+        // Nothing goes out before the commit, and the batch's own task can't draw
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 0, 0, 2, 2, pixels.data()) == ESP_ERR_INVALID_STATE);
+        EXPECT(esp_lcd_panel_rm690b0_cmd_batch_begin(panel.handle) == ESP_ERR_INVALID_STATE);
+        EXPECT(panel.io.call_count() == 0);
+
+        // One write per register, with its last value
+        EXPECT(esp_lcd_panel_rm690b0_cmd_batch_commit(panel.handle) == ESP_OK);
+        EXPECT(panel.io.call_count() == 3);
+        const std::vector<MockPanelIO::Call> orientations = commands(panel.io, madctl);
+        EXPECT(orientations.size() == 1 && orientations.front().param[0] == 0x30);
+        const std::vector<MockPanelIO::Call> levels = commands(panel.io, brightness);
+        EXPECT(levels.size() == 1 && levels.front().param[0] == 20);
+        EXPECT(commands(panel.io, invoff).size() == 1 && commands(panel.io, invon).empty());
+
+        EXPECT(esp_lcd_panel_rm690b0_cmd_batch_commit(panel.handle) == ESP_ERR_INVALID_STATE);
+    }
+
+    void cmd_batch_holds_other_tasks() {
+        TestPanel panel;
+        const std::vector<uint8_t> pixels = pattern(2 * 2 * 2);
+
+        EXPECT(esp_lcd_panel_rm690b0_cmd_batch_begin(panel.handle) == ESP_OK);
+        EXPECT(esp_lcd_panel_mirror(panel.handle, false, true) == ESP_OK);
+
+        // Another task's draw and command wait for the commit, rather than failing or joining the batch
+        std::atomic<esp_err_t> draw_result = ESP_FAIL;
+        std::atomic<esp_err_t> brightness_result = ESP_FAIL;
+        std::thread other([&] {
+            draw_result = esp_lcd_panel_draw_bitmap(panel.handle, 0, 0, 2, 2, pixels.data());
+            brightness_result = esp_lcd_panel_rm690b0_set_brightness(panel.handle, 99);
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT(panel.io.call_count() == 0);
+        EXPECT(draw_result == ESP_FAIL);
+
+        EXPECT(esp_lcd_panel_rm690b0_cmd_batch_commit(panel.handle) == ESP_OK);
+        other.join();
+        EXPECT(draw_result == ESP_OK && brightness_result == ESP_OK);
+
+        // The batch first, then what the other task sent
+        const std::span<const MockPanelIO::Call> calls = panel.io.calls();
+        EXPECT(!calls.empty() && calls.front().command == madctl && calls.front().param[0] == 0x10);
+        EXPECT(!calls.empty() && calls.back().command == brightness && calls.back().param[0] == 99);
+        EXPECT(color_transfers(panel.io) == 1);
+    }
+
+    void fill_detection_sends_from_fill_buffer() {
+        TestPanel panel;
+        constexpr size_t pixel_count = 100 * 100;
+        const std::vector<uint16_t> uniform(pixel_count, 0x1234);
+        std::vector<uint16_t> nearly(pixel_count, 0x1234);
+        nearly.back() = 0x4321;
+
+        EXPECT(esp_lcd_panel_rm690b0_set_fill_detection(panel.handle, true) == ESP_OK);
+
+        // A single color goes out from the 4032-byte fill buffer, over and over
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 0, 0, 100, 100, uniform.data()) == ESP_OK);
+        EXPECT(panel.io.totals().color_bytes == pixel_count * 2);
+        EXPECT(color_transfers(panel.io) == (pixel_count * 2 + 4031) / 4032);
+
+        // One pixel off, and the draw goes out as it is
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 0, 0, 100, 100, nearly.data()) == ESP_OK);
+        EXPECT(panel.io.totals().color_bytes == pixel_count * 2);
+        EXPECT(color_transfers(panel.io) == 1);
+
+        // Without detection, so does a single color
+        EXPECT(esp_lcd_panel_rm690b0_set_fill_detection(panel.handle, false) == ESP_OK);
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_draw_bitmap(panel.handle, 0, 0, 100, 100, uniform.data()) == ESP_OK);
+        EXPECT(color_transfers(panel.io) == 1);
+    }
+
+    void convert_pixels() {
+        // RGB565 red, green and blue, to RGB888
+        const std::array<uint16_t, 3> rgb565 = {0xF800, 0x07E0, 0x001F};
+        std::array<uint8_t, 9> rgb888{};
+        EXPECT(esp_lcd_panel_rm690b0_convert_pixels(RM690B0_PIXEL_FORMAT_RGB565, rgb565.data(),
+                                                    RM690B0_PIXEL_FORMAT_RGB888, rgb888.data(), 3) == ESP_OK);
+        EXPECT((rgb888 == std::array<uint8_t, 9>{0xFF, 0, 0, 0, 0xFF, 0, 0, 0, 0xFF}));
+
+        // RGB666 ignores the bottom two bits of each byte
+        const std::array<uint8_t, 3> rgb666 = {0x87, 0xFF, 0x03};
+        std::array<uint8_t, 3> expanded{};
+        EXPECT(esp_lcd_panel_rm690b0_convert_pixels(RM690B0_PIXEL_FORMAT_RGB666, rgb666.data(),
+                                                    RM690B0_PIXEL_FORMAT_RGB888, expanded.data(), 1) == ESP_OK);
+        EXPECT((expanded == std::array<uint8_t, 3>{0x86, 0xFF, 0x00}));
+
+        // Buffers at odd addresses
+        alignas(4) std::array<uint8_t, 9> unaligned{};
+        EXPECT(esp_lcd_panel_rm690b0_convert_pixels(RM690B0_PIXEL_FORMAT_RGB888, rgb888.data(),
+                                                    RM690B0_PIXEL_FORMAT_RGB565, unaligned.data() + 1, 1) == ESP_OK);
+        EXPECT(unaligned[1] == 0x00 && unaligned[2] == 0xF8);
+
+        std::array<uint8_t, 4> argb{};
+        EXPECT(esp_lcd_panel_rm690b0_convert_pixels(RM690B0_PIXEL_FORMAT_RGB565, unaligned.data() + 1,
+                                                    RM690B0_PIXEL_FORMAT_ARGB8888, argb.data(), 1) == ESP_OK);
+        EXPECT((argb == std::array<uint8_t, 4>{0x00, 0x00, 0xFF, 0xFF}));
+
+        // BT.601 luma of white
+        std::array<uint8_t, 1> gray{};
+        const std::array<uint8_t, 3> white = {0xFF, 0xFF, 0xFF};
+        EXPECT(esp_lcd_panel_rm690b0_convert_pixels(RM690B0_PIXEL_FORMAT_RGB888, white.data(),
+                                                    RM690B0_PIXEL_FORMAT_GRAY8, gray.data(), 1) == ESP_OK);
+        EXPECT(gray[0] == 0xFF);
+
+        EXPECT(esp_lcd_panel_rm690b0_convert_pixels(RM690B0_PIXEL_FORMAT_RGB888, nullptr, RM690B0_PIXEL_FORMAT_GRAY8,
+                                                    gray.data(), 1) == ESP_ERR_INVALID_ARG);
+    }
+
+    void dirty_batch_merges_overlapping_rects() {
+        TestPanel panel;
+        constexpr int fb_width = 200;
+        constexpr int fb_height = 100;
+        const std::vector<uint8_t> framebuffer = pattern(fb_width * fb_height * 2);
+        const rm690b0_batch_config_t config = {framebuffer.data(), fb_width, fb_height, 0};
+
+        // Two overlapping rects become one window, a far away one stays on its own
+        EXPECT(esp_lcd_panel_rm690b0_batch_begin(panel.handle, &config) == ESP_OK);
+        EXPECT(esp_lcd_panel_rm690b0_batch_add(panel.handle, 10, 10, 20, 20) == ESP_OK);
+        EXPECT(esp_lcd_panel_rm690b0_batch_add(panel.handle, 15, 15, 25, 25) == ESP_OK);
+        EXPECT(esp_lcd_panel_rm690b0_batch_add(panel.handle, 150, 80, 190, 95) == ESP_OK);
+        panel.io.clear();
+        EXPECT(esp_lcd_panel_rm690b0_batch_commit(panel.handle) == ESP_OK);
+
+        // Windows are rounded out to the controller's 2-pixel alignment
+        const std::vector<MockPanelIO::Call> columns = commands(panel.io, caset);
+        const std::vector<MockPanelIO::Call> rows = commands(panel.io, raset);
+        EXPECT(commands(panel.io, ramwr).size() == 2);
+        EXPECT(columns.size() == 2 && param16(columns[0], 0) == 10 && param16(columns[0], 1) == 25);
+        EXPECT(rows.size() == 2 && param16(rows[0], 0) == 10 && param16(rows[0], 1) == 25);
+        EXPECT(columns.size() == 2 && param16(columns[1], 0) == 150 && param16(columns[1], 1) == 189);
+        EXPECT(rows.size() == 2 && param16(rows[1], 0) == 80 && param16(rows[1], 1) == 95);
+        EXPECT(panel.io.totals().color_bytes == (16 * 16 + 40 * 16) * 2);
+
+        rm690b0_batch_stats_t stats = {};
+        EXPECT(esp_lcd_panel_rm690b0_get_batch_stats(panel.handle, &stats) == ESP_OK);
+        EXPECT(stats.rects_in == 3 && stats.rects_out == 2);
+    }
+
+    struct Test {
+        const char* name;
+        void (*run)();
+    };
+
+    constexpr std::array tests = {
+        Test{"rejects_empty_and_off_panel_draws", rejects_empty_and_off_panel_draws},
+        Test{"window_cache_skips_address_commands", window_cache_skips_address_commands},
+        Test{"partial_mode_clips_draws", partial_mode_clips_draws},
+        Test{"mirror_and_swap_move_the_window", mirror_and_swap_move_the_window},
+        Test{"scroll_start_follows_mirror", scroll_start_follows_mirror},
+        Test{"cmd_batch_folds_register_writes", cmd_batch_folds_register_writes},
+        Test{"cmd_batch_holds_other_tasks", cmd_batch_holds_other_tasks},
+        Test{"fill_detection_sends_from_fill_buffer", fill_detection_sends_from_fill_buffer},
+        Test{"convert_pixels", convert_pixels},
+        Test{"dirty_batch_merges_overlapping_rects", dirty_batch_merges_overlapping_rects},
+    };
+}
+
+int main() {
+    int failed_tests = 0;
+
+    for (const Test& test : tests) {
+        const int failures_before = failures;
+        test.run();
+
+        const bool passed = failures == failures_before;
+        failed_tests += !passed;
+        std::printf("%-40s %s\n", test.name, passed ? "ok" : "FAILED");
+    }
+
+    std::printf("%zu tests, %d failed\n", tests.size(), failed_tests);
+    return failed_tests ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+#include "mock_panel_io.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    int64_t steady_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+}
+
+MockPanelIO::MockPanelIO() {
+    port.io = {
+        .rx_param = rx_param,
+        .tx_param = tx_param,
+        .tx_color = tx_color,
+        .del = del,
+        .register_event_callbacks = register_event_callbacks,
+    };
+    port.mock = this;
+
+    clear();
+}
+
+void MockPanelIO::clear() {
+    count = 0;
+    sums = {};
+    start_ns = steady_ns();
+}
+
+void MockPanelIO::complete_pending() {
+    for (; pending; --pending) {
+        complete();
+    }
+}
+
+MockPanelIO& MockPanelIO::of(esp_lcd_panel_io_t* io) {
+    return *reinterpret_cast<Port*>(io)->mock; // io is the first member of a Port
+}
+
+void MockPanelIO::record(const Kind kind, const int lcd_cmd, const void* data, const size_t bytes) {
+    if (count < max_calls) {
+        Call& call = log.at(count);
+        call = {
+            .kind = kind,
+            .command = static_cast<uint8_t>(lcd_cmd >> 8 & 0xFF), // NOLINT(*-magic-numbers)
+            .lcd_cmd = lcd_cmd,
+            .bytes = bytes,
+            .param = {},
+            .at_ns = steady_ns() - start_ns,
+        };
+
+        if (kind == Kind::param && data) {
+            std::memcpy(call.param.data(), data, std::min(bytes, call.param.size()));
+        }
+    }
+
+    ++count;
+
+    if (kind == Kind::param) {
+        ++sums.commands;
+        sums.param_bytes += bytes;
+    } else {
+        ++sums.colors;
+        sums.color_bytes += bytes;
+    }
+}
+
+void MockPanelIO::complete() {
+    if (on_color_trans_done) {
+        on_color_trans_done(&port.io, nullptr, user_ctx);
+    }
+}
+
+// Reads return zeros: the benchmark doesn't read back
+esp_err_t MockPanelIO::rx_param(esp_lcd_panel_io_t*, int, void* param, const size_t param_size) {
+    std::memset(param, 0, param_size);
+    return ESP_OK;
+}
+
+// Like the real panel IO, a command goes out only once the color transfers before it have
+esp_err_t MockPanelIO::tx_param(esp_lcd_panel_io_t* io, const int lcd_cmd, const void* param,
+                                const size_t param_size) {
+    MockPanelIO& mock = of(io);
+
+    mock.complete_pending();
+    mock.record(Kind::param, lcd_cmd, param, param_size);
+    return ESP_OK;
+}
+
+esp_err_t MockPanelIO::tx_color(esp_lcd_panel_io_t* io, const int lcd_cmd, const void* color,
+                                const size_t color_size) {
+    MockPanelIO& mock = of(io);
+
+    mock.record(Kind::color, lcd_cmd, color, color_size);
+
+    if (mock.complete_later) {
+        ++mock.pending;
+    } else {
+        mock.complete();
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t MockPanelIO::del(esp_lcd_panel_io_t*) {
+    return ESP_OK;
+}
+
+esp_err_t MockPanelIO::register_event_callbacks(esp_lcd_panel_io_t* io, const esp_lcd_panel_io_callbacks_t* cbs,
+                                                void* user_ctx) {
+    MockPanelIO& mock = of(io);
+
+    mock.on_color_trans_done = cbs->on_color_trans_done;
+    mock.user_ctx = user_ctx;
+    return ESP_OK;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "esp_lcd_panel_io_interface.h"
+
+/**
+ * @brief Panel IO that records what the driver sends instead of sending it
+ *
+ * Each tx_param and tx_color call is logged with the time since the last `clear()`. The log has a fixed
+ * size, so recording allocates nothing and doesn't skew the allocation counts of the driver.
+ *
+ * Color transfers finish at once by default: tx_color calls the transfer-done callback before returning,
+ * as if the DMA were infinitely fast. With `complete_later`, they pile up until `complete_pending()`.
+ */
+class MockPanelIO {
+public:
+    enum class Kind : uint8_t { param, color };
+
+    struct Call {
+        Kind kind;
+        uint8_t command;              ///< Command address, e.g. 0x2C for RAMWR
+        int lcd_cmd;                  ///< What the driver passed, with the bus's opcode
+        size_t bytes;                 ///< Parameter or color bytes
+        std::array<uint8_t, 8> param; ///< The first parameter bytes
+        int64_t at_ns;                ///< Time of the call, since the last `clear()`
+    };
+
+    // Sums over all calls since the last `clear()`, those past `max_calls` included
+    struct Totals {
+        size_t commands;    ///< tx_param calls
+        size_t param_bytes; ///< Parameter bytes they sent
+        size_t colors;      ///< tx_color calls
+        size_t color_bytes; ///< Color bytes they sent
+    };
+
+    static constexpr size_t max_calls = 4096;
+
+    MockPanelIO();
+
+    MockPanelIO(const MockPanelIO&) = delete;
+    MockPanelIO& operator=(const MockPanelIO&) = delete;
+
+    [[nodiscard]] esp_lcd_panel_io_handle_t handle() { return &port.io; }
+
+    /// Calls since the last `clear()`, up to `max_calls`
+    [[nodiscard]] std::span<const Call> calls() const { return {log.data(), std::min(count, max_calls)}; }
+
+    /// Calls since the last `clear()`, including those that didn't fit
+    [[nodiscard]] size_t call_count() const { return count; }
+
+    [[nodiscard]] const Totals& totals() const { return sums; }
+
+    void clear();
+
+    bool complete_later = false;
+
+    /// Finish the color transfers held back by `complete_later`
+    void complete_pending();
+
+private:
+    static esp_err_t rx_param(esp_lcd_panel_io_t* io, int lcd_cmd, void* param, size_t param_size);
+    static esp_err_t tx_param(esp_lcd_panel_io_t* io, int lcd_cmd, const void* param, size_t param_size);
+    static esp_err_t tx_color(esp_lcd_panel_io_t* io, int lcd_cmd, const void* color, size_t color_size);
+    static esp_err_t del(esp_lcd_panel_io_t* io);
+    static esp_err_t register_event_callbacks(esp_lcd_panel_io_t* io, const esp_lcd_panel_io_callbacks_t* cbs,
+                                              void* user_ctx);
+
+    static MockPanelIO& of(esp_lcd_panel_io_t* io);
+
+    void record(Kind kind, int lcd_cmd, const void* data, size_t bytes);
+    void complete();
+
+    // The panel IO the driver sees, and the way back from it to us
+    struct Port {
+        esp_lcd_panel_io_t io;
+        MockPanelIO* mock;
+    };
+
+    Port port{};
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done = nullptr;
+    void* user_ctx = nullptr;
+
+    std::array<Call, max_calls> log{};
+    size_t count = 0;
+    Totals sums{};
+    int64_t start_ns = 0;
+    size_t pending = 0;
+};
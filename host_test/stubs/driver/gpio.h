@@ -0,0 +1,21 @@
+#pragma once
+
+#include "esp_err.h"
+#include "hal/gpio_types.h"
+
+typedef void (*gpio_isr_t)(void* arg); // NOLINT(*-use-using)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t gpio_config(const gpio_config_t* config);
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num);
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level);
+esp_err_t gpio_install_isr_service(int intr_alloc_flags);
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args);
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num);
+
+#ifdef __cplusplus
+}
+#endif
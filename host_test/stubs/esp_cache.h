@@ -0,0 +1,19 @@
+#pragma once
+
+#include "esp_err.h"
+
+#define ESP_CACHE_MSYNC_FLAG_INVALIDATE (1 << 0)
+#define ESP_CACHE_MSYNC_FLAG_UNALIGNED (1 << 1)
+#define ESP_CACHE_MSYNC_FLAG_DIR_C2M (1 << 2)
+#define ESP_CACHE_MSYNC_FLAG_DIR_M2C (1 << 3)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t esp_cache_msync(void* addr, size_t size, int flags);
+esp_err_t esp_cache_get_alignment(uint32_t heap_caps, size_t* out_alignment);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+
+#define LCD_CMD_SLPIN 0x10
+#define LCD_CMD_SLPOUT 0x11
+#define LCD_CMD_PTLON 0x12
+#define LCD_CMD_NORON 0x13
+#define LCD_CMD_INVOFF 0x20
+#define LCD_CMD_INVON 0x21
+#define LCD_CMD_DISPOFF 0x28
+#define LCD_CMD_DISPON 0x29
+#define LCD_CMD_CASET 0x2A
+#define LCD_CMD_RASET 0x2B
+#define LCD_CMD_RAMWR 0x2C
+#define LCD_CMD_RAMRD 0x2E
+#define LCD_CMD_PTLAR 0x30
+#define LCD_CMD_VSCRDEF 0x33
+#define LCD_CMD_TEON 0x35
+#define LCD_CMD_MADCTL 0x36
+#define LCD_CMD_VSCSAD 0x37
+#define LCD_CMD_IDMOFF 0x38
+#define LCD_CMD_IDMON 0x39
+#define LCD_CMD_COLMOD 0x3A
+#define LCD_CMD_RAMWRC 0x3C
+#define LCD_CMD_RAMRDC 0x3E
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "esp_lcd_types.h"
+
+typedef struct { // NOLINT(*-use-using)
+    int reset_gpio_num;
+    union {
+        lcd_rgb_element_order_t rgb_ele_order;
+        lcd_color_space_t color_space;
+    };
+    lcd_rgb_data_endian_t data_endian;
+    uint32_t bits_per_pixel;
+    struct {
+        uint32_t reset_active_high : 1;
+    } flags;
+    void* vendor_config;
+} esp_lcd_panel_dev_config_t;
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "esp_lcd_types.h"
+
+typedef struct { // NOLINT(*-use-using)
+} esp_lcd_panel_io_event_data_t;
+
+typedef bool (*esp_lcd_panel_io_color_trans_done_cb_t)(esp_lcd_panel_io_handle_t panel_io, // NOLINT(*-use-using)
+                                                       esp_lcd_panel_io_event_data_t* edata, void* user_ctx);
+
+typedef struct { // NOLINT(*-use-using)
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;
+} esp_lcd_panel_io_callbacks_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t esp_lcd_panel_io_register_event_callbacks(esp_lcd_panel_io_handle_t io,
+                                                    const esp_lcd_panel_io_callbacks_t* cbs, void* user_ctx);
+
+#ifdef __cplusplus
+}
+#endif
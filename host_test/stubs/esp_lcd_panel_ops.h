@@ -0,0 +1,38 @@
+#pragma once
+
+#include "esp_lcd_panel_interface.h"
+
+// The esp_lcd component's wrappers, which only forward to the panel's callbacks
+
+static inline esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel) {
+    return panel->reset(panel);
+}
+
+static inline esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel) {
+    return panel->init(panel);
+}
+
+static inline esp_err_t esp_lcd_panel_del(esp_lcd_panel_handle_t panel) {
+    return panel->del(panel);
+}
+
+static inline esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end,
+                                                  int y_end, const void* color_data) {
+    return panel->draw_bitmap(panel, x_start, y_start, x_end, y_end, color_data);
+}
+
+static inline esp_err_t esp_lcd_panel_mirror(esp_lcd_panel_handle_t panel, bool mirror_x, bool mirror_y) {
+    return panel->mirror(panel, mirror_x, mirror_y);
+}
+
+static inline esp_err_t esp_lcd_panel_swap_xy(esp_lcd_panel_handle_t panel, bool swap_axes) {
+    return panel->swap_xy(panel, swap_axes);
+}
+
+static inline esp_err_t esp_lcd_panel_set_gap(esp_lcd_panel_handle_t panel, int x_gap, int y_gap) {
+    return panel->set_gap(panel, x_gap, y_gap);
+}
+
+static inline esp_err_t esp_lcd_panel_invert_color(esp_lcd_panel_handle_t panel, bool invert_color_data) {
+    return panel->invert_color(panel, invert_color_data);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "esp_err.h"
+
+typedef struct esp_lcd_panel_io_t* esp_lcd_panel_io_handle_t; // NOLINT(*-use-using)
+typedef struct esp_lcd_panel_t* esp_lcd_panel_handle_t;       // NOLINT(*-use-using)
+
+typedef enum { LCD_RGB_ELEMENT_ORDER_RGB, LCD_RGB_ELEMENT_ORDER_BGR } lcd_rgb_element_order_t; // NOLINT(*-use-using)
+typedef enum { LCD_RGB_DATA_ENDIAN_BIG, LCD_RGB_DATA_ENDIAN_LITTLE } lcd_rgb_data_endian_t;   // NOLINT(*-use-using)
+typedef enum { LCD_COLOR_SPACE_RGB, LCD_COLOR_SPACE_BGR } lcd_color_space_t;                  // NOLINT(*-use-using)
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Memory from heap_caps_malloc() with MALLOC_CAP_SPIRAM counts as PSRAM, anything else as internal DMA-capable RAM
+bool esp_ptr_dma_capable(const void* p);
+bool esp_ptr_external_ram(const void* p);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "esp_err.h"
+
+typedef struct esp_pm_lock* esp_pm_lock_handle_t; // NOLINT(*-use-using)
+
+typedef enum { // NOLINT(*-use-using)
+    ESP_PM_CPU_FREQ_MAX,
+    ESP_PM_APB_FREQ_MAX,
+    ESP_PM_NO_LIGHT_SLEEP,
+} esp_pm_lock_type_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char* name, esp_pm_lock_handle_t* out_handle);
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle);
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle);
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
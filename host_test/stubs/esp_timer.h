@@ -0,0 +1,35 @@
+#pragma once
+
+#include "esp_err.h"
+
+typedef struct esp_timer* esp_timer_handle_t; // NOLINT(*-use-using)
+typedef void (*esp_timer_cb_t)(void* arg);    // NOLINT(*-use-using)
+
+typedef enum { // NOLINT(*-use-using)
+    ESP_TIMER_TASK,
+    ESP_TIMER_ISR,
+} esp_timer_dispatch_t;
+
+typedef struct { // NOLINT(*-use-using)
+    esp_timer_cb_t callback;
+    void* arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char* name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Timers never fire on their own: time is simulated, see host_idf.h
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period);
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+esp_err_t esp_timer_delete(esp_timer_handle_t timer);
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
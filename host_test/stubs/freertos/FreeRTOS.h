@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int BaseType_t;           // NOLINT(*-use-using)
+typedef unsigned int UBaseType_t; // NOLINT(*-use-using)
+typedef uint32_t TickType_t;      // NOLINT(*-use-using)
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms)) // 1 kHz tick
+
+#define portNUM_PROCESSORS 2
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+// Everything runs in one process, and critical sections take one lock for all spinlocks
+typedef struct { // NOLINT(*-use-using)
+    uint32_t unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void vPortEnterCritical(portMUX_TYPE* mux);
+void vPortExitCritical(portMUX_TYPE* mux);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define portENTER_CRITICAL(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux) vPortExitCritical(mux)
+#define portENTER_CRITICAL_SAFE(mux) vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_SAFE(mux) vPortExitCritical(mux)
+#define portYIELD_FROM_ISR(...) ((void)0)
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct QueueDefinition* QueueHandle_t; // NOLINT(*-use-using)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks);
+void vQueueDelete(QueueHandle_t queue);
+
+#ifdef __cplusplus
+}
+#endif
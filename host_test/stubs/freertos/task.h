@@ -0,0 +1,22 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct tskTaskControlBlock* TaskHandle_t; // NOLINT(*-use-using)
+typedef void (*TaskFunction_t)(void* arg);        // NOLINT(*-use-using)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tasks are threads; vTaskDelay() advances the simulated clock instead of sleeping
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stack_depth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* created_task, BaseType_t core_id);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xPortGetCoreID(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Controls for the host stand-ins of ESP-IDF, for the benchmark and tests
+namespace host_idf {
+    // Allocations through heap_caps_*() and operator new since the start
+    struct Allocations {
+        size_t count;
+        size_t bytes;
+    };
+
+    Allocations allocations();
+
+    // Time as esp_timer_get_time() sees it. It only moves when told to, or when a task delays or a
+    // semaphore times out, so runs are repeatable.
+    int64_t now_us();
+
+    // Move time on, running the esp_timer callbacks that come due on the way
+    void advance_time(int64_t us);
+
+    // Log level below which esp_log_write() prints, ESP_LOG_WARN by default
+    void set_log_level(int level);
+}
@@ -0,0 +1,507 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "driver/gpio.h"
+#include "esp_cache.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_io_interface.h"
+#include "esp_log.h"
+#include "esp_memory_utils.h"
+#include "esp_pm.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "host_idf.h"
+#include "nvs.h"
+
+namespace {
+    std::atomic<size_t> allocation_count = 0;
+    std::atomic<size_t> allocation_bytes = 0;
+    std::atomic<int64_t> now = 0;
+    int log_level = ESP_LOG_WARN;
+
+    void count_allocation(const size_t size) {
+        ++allocation_count;
+        allocation_bytes += size;
+    }
+
+    // PSRAM allocations, so esp_ptr_dma_capable() can tell them apart
+    struct Region {
+        const uint8_t* start;
+        size_t size;
+    };
+
+    std::mutex psram_lock;
+    std::vector<Region> psram;
+
+    void* allocate(const size_t alignment, const size_t size, const uint32_t caps) {
+        count_allocation(size);
+
+        void* ptr = std::aligned_alloc(alignment, (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment);
+        if (ptr && caps & MALLOC_CAP_SPIRAM) {
+            const std::lock_guard lock(psram_lock);
+            psram.push_back({static_cast<const uint8_t*>(ptr), size});
+        }
+
+        return ptr;
+    }
+
+    // One lock and condition variable for all semaphores and queues: simple, and plenty for a benchmark
+    std::mutex sync_lock;
+    std::condition_variable sync_changed;
+
+    // How long a task may wait forever before we call it a deadlock
+    constexpr auto deadlock_timeout = std::chrono::seconds(5);
+
+    // Wait for `ready` under sync_lock. A finite wait doesn't wait at all: nobody else would move the
+    // simulated time on, so the time passes at once.
+    template <typename Ready>
+    bool wait(std::unique_lock<std::mutex>& lock, const TickType_t ticks, Ready ready) {
+        if (ready()) {
+            return true;
+        }
+
+        if (ticks != portMAX_DELAY) {
+            now += static_cast<int64_t>(ticks) * 1000;
+            return false;
+        }
+
+        if (!sync_changed.wait_for(lock, deadlock_timeout, ready)) {
+            std::fprintf(stderr, "host_idf: task blocked for good\n");
+            std::abort();
+        }
+
+        return true;
+    }
+
+    // Critical sections nest, and the mock panel IO calls transfer-done callbacks from inside the driver
+    std::recursive_mutex& critical_lock() {
+        static std::recursive_mutex lock;
+        return lock;
+    }
+
+    thread_local uint8_t task_tag;
+    std::mutex nvs_lock;
+    std::map<std::string, uint32_t> nvs_values;
+}
+
+// A semaphore is a queue of empty items, as in FreeRTOS. Item storage is allocated with the queue,
+// so sending doesn't allocate.
+struct QueueDefinition {
+    UBaseType_t count;
+    UBaseType_t max_count;
+    size_t item_size = 0;
+    std::vector<uint8_t> items = std::vector<uint8_t>(max_count * item_size);
+    size_t head = 0;
+};
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    bool armed = false;
+    int64_t due_us = 0;
+    uint64_t period_us = 0;
+};
+
+namespace {
+    std::vector<esp_timer*> timers;
+}
+
+namespace host_idf {
+    Allocations allocations() {
+        return {allocation_count, allocation_bytes};
+    }
+
+    int64_t now_us() {
+        return now;
+    }
+
+    void advance_time(const int64_t us) {
+        const int64_t until = now + us;
+
+        for (;;) {
+            esp_timer* next = nullptr;
+            for (esp_timer* timer : timers) {
+                if (timer->armed && timer->due_us <= until && (!next || timer->due_us < next->due_us)) {
+                    next = timer;
+                }
+            }
+
+            if (!next) {
+                break;
+            }
+
+            now = std::max<int64_t>(now, next->due_us);
+            next->armed = next->period_us != 0;
+            next->due_us += static_cast<int64_t>(next->period_us);
+            next->callback(next->arg);
+        }
+
+        now = until;
+    }
+
+    void set_log_level(const int level) {
+        log_level = level;
+    }
+}
+
+void* operator new(const size_t size) {
+    count_allocation(size);
+
+    if (void* ptr = std::malloc(std::max<size_t>(size, 1))) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+extern "C" {
+const char* esp_err_to_name(const esp_err_t code) {
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    default:
+        return "ESP_ERR_?";
+    }
+}
+
+void esp_log_level_set(const char*, esp_log_level_t) {}
+
+void esp_log_write(const esp_log_level_t level, const char* tag, const char* format, ...) {
+    if (level > log_level) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    std::fprintf(stderr, "[%s] ", tag);
+    std::vfprintf(stderr, format, args);
+    std::fputc('\n', stderr);
+    va_end(args);
+}
+
+esp_err_t gpio_config(const gpio_config_t*) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t, uint32_t) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t, gpio_isr_t, void*) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t) {
+    return ESP_OK;
+}
+
+void* heap_caps_malloc(const size_t size, const uint32_t caps) {
+    return allocate(alignof(std::max_align_t), size, caps);
+}
+
+void* heap_caps_calloc(const size_t n, const size_t size, const uint32_t caps) {
+    return heap_caps_aligned_calloc(alignof(std::max_align_t), n, size, caps);
+}
+
+void* heap_caps_aligned_alloc(const size_t alignment, const size_t size, const uint32_t caps) {
+    return allocate(alignment, size, caps);
+}
+
+void* heap_caps_aligned_calloc(const size_t alignment, const size_t n, const size_t size, const uint32_t caps) {
+    void* ptr = allocate(alignment, n * size, caps);
+    if (ptr) {
+        std::memset(ptr, 0, n * size);
+    }
+
+    return ptr;
+}
+
+void heap_caps_free(void* ptr) {
+    {
+        const std::lock_guard lock(psram_lock);
+        std::erase_if(psram, [ptr](const Region& region) { return region.start == ptr; });
+    }
+
+    std::free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t) {
+    return SIZE_MAX / 2;
+}
+
+bool esp_ptr_external_ram(const void* p) {
+    const auto* byte = static_cast<const uint8_t*>(p);
+    const std::lock_guard lock(psram_lock);
+
+    return std::ranges::any_of(psram, [byte](const Region& region) {
+        return byte >= region.start && byte < region.start + region.size;
+    });
+}
+
+bool esp_ptr_dma_capable(const void* p) {
+    return !esp_ptr_external_ram(p);
+}
+
+esp_err_t esp_cache_msync(void*, size_t, int) {
+    return ESP_OK;
+}
+
+esp_err_t esp_cache_get_alignment(uint32_t, size_t* out_alignment) {
+    *out_alignment = 64; // NOLINT(*-magic-numbers): the ESP32-S3's PSRAM cache line
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle) {
+    *out_handle = new esp_timer{create_args->callback, create_args->arg};
+    timers.push_back(*out_handle);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, const uint64_t timeout_us) {
+    if (timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *timer = {timer->callback, timer->arg, true, now + static_cast<int64_t>(timeout_us), 0};
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, const uint64_t period) {
+    if (timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *timer = {timer->callback, timer->arg, true, now + static_cast<int64_t>(period), period};
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    if (!timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    timer->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    std::erase(timers, timer);
+    delete timer;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void) {
+    return now;
+}
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t, int, const char*, esp_pm_lock_handle_t* out_handle) {
+    static uint8_t lock;
+    *out_handle = reinterpret_cast<esp_pm_lock_handle_t>(&lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t) {
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t) {
+    return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char*, nvs_open_mode_t, nvs_handle_t* out_handle) {
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t, const char* key, const uint32_t value) {
+    const std::lock_guard lock(nvs_lock);
+    nvs_values[key] = value;
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t, const char* key, uint32_t* out_value) {
+    const std::lock_guard lock(nvs_lock);
+    const auto found = nvs_values.find(key);
+    if (found == nvs_values.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    *out_value = found->second;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t) {
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t) {}
+
+void vPortEnterCritical(portMUX_TYPE*) {
+    critical_lock().lock();
+}
+
+void vPortExitCritical(portMUX_TYPE*) {
+    critical_lock().unlock();
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char*, uint32_t, void* arg, UBaseType_t,
+                                   TaskHandle_t* created_task, BaseType_t) {
+    static std::atomic<uintptr_t> next_handle = 1;
+    if (created_task) {
+        *created_task = reinterpret_cast<TaskHandle_t>(next_handle++);
+    }
+
+    std::thread(task, arg).detach();
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t) {}
+
+void vTaskDelay(const TickType_t ticks) {
+    now += static_cast<int64_t>(ticks) * 1000;
+    std::this_thread::yield();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return reinterpret_cast<TaskHandle_t>(&task_tag);
+}
+
+BaseType_t xPortGetCoreID(void) {
+    return 0;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return new QueueDefinition{0, 1};
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return new QueueDefinition{1, 1};
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(const UBaseType_t max_count, const UBaseType_t initial_count) {
+    return new QueueDefinition{initial_count, max_count};
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, const TickType_t ticks) {
+    std::unique_lock lock(sync_lock);
+    if (!wait(lock, ticks, [semaphore] { return semaphore->count > 0; })) {
+        return pdFALSE;
+    }
+
+    --semaphore->count;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    const std::lock_guard lock(sync_lock);
+    if (semaphore->count >= semaphore->max_count) {
+        return pdFALSE;
+    }
+
+    ++semaphore->count;
+    sync_changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higher_priority_task_woken) {
+    if (higher_priority_task_woken) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+
+    return xSemaphoreGive(semaphore);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+QueueHandle_t xQueueCreate(const UBaseType_t length, const UBaseType_t item_size) {
+    return new QueueDefinition{0, length, item_size};
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, const TickType_t ticks) {
+    std::unique_lock lock(sync_lock);
+    if (!wait(lock, ticks, [queue] { return queue->count < queue->max_count; })) {
+        return pdFALSE;
+    }
+
+    const size_t tail = (queue->head + queue->count) % queue->max_count;
+    std::memcpy(&queue->items.at(tail * queue->item_size), item, queue->item_size);
+    ++queue->count;
+    sync_changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, const TickType_t ticks) {
+    std::unique_lock lock(sync_lock);
+    if (!wait(lock, ticks, [queue] { return queue->count > 0; })) {
+        return pdFALSE;
+    }
+
+    std::memcpy(item, &queue->items.at(queue->head * queue->item_size), queue->item_size);
+    queue->head = (queue->head + 1) % queue->max_count;
+    --queue->count;
+    sync_changed.notify_all();
+    return pdTRUE;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+esp_err_t esp_lcd_panel_io_register_event_callbacks(esp_lcd_panel_io_handle_t io,
+                                                    const esp_lcd_panel_io_callbacks_t* cbs, void* user_ctx) {
+    return io->register_event_callbacks(io, cbs, user_ctx);
+}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "esp_err.h"
+
+#define ESP_ERR_NVS_NOT_FOUND 0x1102
+
+typedef uint32_t nvs_handle_t; // NOLINT(*-use-using)
+
+typedef enum { // NOLINT(*-use-using)
+    NVS_READONLY,
+    NVS_READWRITE,
+} nvs_open_mode_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t nvs_open(const char* namespace_name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle);
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char* key, uint32_t value);
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char* key, uint32_t* out_value);
+esp_err_t nvs_commit(nvs_handle_t handle);
+void nvs_close(nvs_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,33 @@
 
 const uint32_t rm690b0_spi_clock_hz = 80 * 1000 * 1000;
 
+/**
+ * @brief One command of an init sequence
+ *
+ * Tables of these can be `const` (or `constexpr` in C++), so they live in flash.
+ */
+typedef struct { // NOLINT(*-use-using)
+    uint8_t cmd;           ///< Command address, e.g. 0x11 for SLPOUT
+    const void* data;      ///< Parameters, or NULL if there are none
+    size_t data_bytes;     ///< Number of parameter bytes
+    unsigned int delay_ms; ///< Time the controller needs after this command
+} rm690b0_lcd_init_cmd_t;
+
+/**
+ * @brief Bus the panel is wired to, which decides how commands are framed
+ *
+ * Set up the panel IO to match: QSPI takes `lcd_cmd_bits = 32` and `quad_mode`, all other buses
+ * `lcd_cmd_bits = 8`. `lcd_param_bits` is 8 on all of them. The data width is the panel IO's.
+ */
+typedef enum { // NOLINT(*-use-using)
+    RM690B0_BUS_QSPI,      ///< Quad SPI: commands in the 32-bit instruction phase, pixels on four lines (default)
+    RM690B0_BUS_SPI,       ///< SPI with a D/C line
+    RM690B0_BUS_OCTAL_SPI, ///< Octal SPI, `esp_lcd_panel_io_spi` in `octal_mode`
+    RM690B0_BUS_I80_8BIT,  ///< Intel 8080 parallel, 8 data lines
+    RM690B0_BUS_I80_16BIT, ///< Intel 8080 parallel, 16 data lines. RGB565 pixels go out as one bus cycle each.
+    RM690B0_BUS_DSI,       ///< MIPI DSI command mode, through `esp_lcd_new_panel_io_dbi()`
+} rm690b0_bus_t;
+
 /**
  * @brief LCD panel vendor configuration.
  *
@@ -15,12 +42,281 @@ const uint32_t rm690b0_spi_clock_hz = 80 * 1000 * 1000;
 typedef struct { // NOLINT(*-use-using)
     gpio_num_t en_gpio_num;
     bool grayscale;
+
+    /// GPIO connected to the controller's tearing effect (TE) output. Only used if `use_te` is set,
+    /// because 0 is a valid GPIO and configs written before this field existed leave it at 0.
+    gpio_num_t te_gpio_num;
+    bool use_te;
+    /// Start every `esp_lcd_panel_draw_bitmap()` at a TE edge. Can be changed later with
+    /// `esp_lcd_panel_rm690b0_set_te_sync()`.
+    bool te_sync;
+
+    /// Size in bytes of each of the two streaming buffers, or 0 to disable streaming.
+    ///
+    /// With streaming enabled, pixels that aren't in internal DMA-capable RAM (e.g. a PSRAM framebuffer)
+    /// are sent in bands: one band is copied into a buffer while the other is on the wire.
+    /// The driver then owns the panel IO's `on_color_trans_done` callback; use
+    /// `esp_lcd_panel_rm690b0_register_event_callbacks()` instead of the IO config's callback.
+    /// Must be at least 24 bytes.
+    size_t stream_buffer_size;
+
+    /// Init sequence replacing the driver's default, e.g. for another panel glass, or NULL for the default.
+    /// It must bring the panel out of sleep and turn the display on; the driver then sends MADCTL, COLMOD
+    /// and brightness itself. The table must stay valid while the panel exists.
+    const rm690b0_lcd_init_cmd_t* init_cmds;
+    size_t init_cmds_size; ///< Number of commands in `init_cmds`, at least 1
+
+    rm690b0_bus_t bus; ///< Bus the panel IO drives. Left at 0, QSPI.
+
+    /// Panel size in pixels, before `esp_lcd_panel_swap_xy()`. The controller can't mirror x without
+    /// swapping the axes, nor mirror both axes of a swapped panel; with the size set, the driver mirrors
+    /// those draws itself, through the streaming buffers. Left at 0, such orientations come out wrong.
+    int width;
+    int height;
 } rm960b0_vendor_config_t;
 
+/**
+ * @brief Panel refresh timing, measured from the TE pin
+ */
+typedef struct { // NOLINT(*-use-using)
+    uint32_t period_us;      ///< Smoothed time between TE pulses, i.e. the panel's refresh period
+    int64_t last_te_time_us; ///< `esp_timer_get_time()` at the latest TE pulse
+    uint32_t te_count;       ///< Number of TE pulses seen since the panel was created
+} rm690b0_frame_timing_t;
+
+/**
+ * @brief Configuration of a dirty-rectangle batch
+ */
+typedef struct { // NOLINT(*-use-using)
+    const void* framebuffer; ///< Full-screen framebuffer the dirty rectangles are drawn from
+    int width;               ///< Framebuffer width in pixels. Rows are exactly this many pixels apart.
+    int height;              ///< Framebuffer height in pixels
+    /// Fixed cost of sending one extra window, in pixel bytes. Merging two rectangles pays off when the
+    /// extra pixels it sends cost less than this. 0 picks a default suited to QSPI at 80 MHz.
+    uint32_t window_overhead_bytes;
+} rm690b0_batch_config_t;
+
+/**
+ * @brief Dirty-rectangle batching counters, accumulated over all batches
+ */
+typedef struct { // NOLINT(*-use-using)
+    uint32_t rects_in;   ///< Rectangles added to batches
+    uint32_t rects_out;  ///< Windows actually sent
+    uint64_t bytes_in;   ///< Pixel bytes of the rectangles as added
+    uint64_t bytes_out;  ///< Pixel bytes actually sent
+    int64_t bytes_saved; ///< Bus bytes saved, counting each window's overhead: (in + overhead) - (out + overhead)
+} rm690b0_batch_stats_t;
+
+/**
+ * @brief Where flush time goes
+ *
+ * A flush is a `esp_lcd_panel_draw_bitmap()` call or a batch commit. Its latency runs from the call to
+ * the end of its last transfer, if the driver sees transfers finish (with streaming or
+ * `esp_lcd_panel_rm690b0_register_event_callbacks()`), and only until the call returns otherwise.
+ */
+typedef struct { // NOLINT(*-use-using)
+    uint32_t command_count;        ///< Commands sent, including those of init and sleep sequences
+    uint32_t flush_count;          ///< Flushes whose latency has been recorded
+    uint32_t flush_calls;          ///< Flushes started, latency recorded or not: divide by it for per-flush costs
+    uint64_t pixel_bytes;          ///< Pixel bytes queued
+    uint64_t window_setup_time_us; ///< Time spent in CASET, RASET and RAMWR
+    uint64_t te_wait_time_us;      ///< Time spent waiting for TE
+    uint64_t color_time_us;        ///< Time spent queuing pixels, including streaming them through the band buffers
+    uint32_t latency_min_us;       ///< Shortest flush latency
+    uint32_t latency_max_us;       ///< Longest flush latency
+    uint32_t latency_avg_us;       ///< Average flush latency
+    float throughput_mb_per_s;     ///< Pixel bytes per second of flush latency, in MB/s
+    uint32_t init_time_us;         ///< Duration of the latest init, sync or async, delays included
+    uint64_t readback_bytes;       ///< Pixel bytes read back with `esp_lcd_panel_rm690b0_read_area()`
+    uint64_t readback_time_us;     ///< Time spent reading them, window setup included
+    float readback_mb_per_s;       ///< Readback bytes per second of readback time, in MB/s
+    rm690b0_bus_t bus;             ///< Bus the figures were measured on
+} rm690b0_stats_t;
+
+/**
+ * @brief Brightness curves for `esp_lcd_panel_rm690b0_fade_brightness()`
+ */
+typedef enum { // NOLINT(*-use-using)
+    RM690B0_FADE_LINEAR, ///< Even steps of the brightness register
+    RM690B0_FADE_GAMMA,  ///< Even steps of perceived lightness (gamma 2.2), which looks smoother
+} rm690b0_fade_curve_t;
+
+/**
+ * @brief Pixel formats understood by the conversion engine
+ *
+ * Multi-byte pixels are in native (little-endian) byte order and must be naturally aligned.
+ */
+typedef enum { // NOLINT(*-use-using)
+    RM690B0_PIXEL_FORMAT_RGB565,   ///< uint16_t 0bRRRRRGGGGGGBBBBB, as the driver configures the panel for 16 bpp
+    RM690B0_PIXEL_FORMAT_RGB666,   ///< 3 bytes R, G, B, each in the top 6 bits, as sent to the panel at 18 bpp
+    RM690B0_PIXEL_FORMAT_RGB888,   ///< 3 bytes R, G, B, as sent to the panel at 24 bpp
+    RM690B0_PIXEL_FORMAT_ARGB8888, ///< uint32_t 0xAARRGGBB. Alpha is ignored.
+    RM690B0_PIXEL_FORMAT_GRAY8,    ///< 1 byte luma, as sent to the panel at 8 bpp grayscale
+} rm690b0_pixel_format_t;
+
+/**
+ * @brief Configuration of the pipelined flush
+ */
+typedef struct { // NOLINT(*-use-using)
+    /// Core the transfer task is pinned to, -1 for the core other than the one calling
+    /// `esp_lcd_panel_rm690b0_start_pipeline()`, or tskNO_AFFINITY not to pin it. Ignored on single-core chips.
+    int core_id;
+    unsigned int task_priority; ///< FreeRTOS priority of the transfer task, or 0 for the default (5)
+    size_t queue_depth;         ///< Flushes that can wait for the transfer task, or 0 for the default (2)
+} rm690b0_pipeline_config_t;
+
+/**
+ * @brief Configuration of the driver's own framebuffers
+ */
+typedef struct { // NOLINT(*-use-using)
+    int width;       ///< Framebuffer width in pixels, usually the panel's
+    int height;      ///< Framebuffer height in pixels
+    size_t num_fbs;  ///< 1 to 3 framebuffers, for single, double or triple buffering
+    /// The panel IO's DMA can read PSRAM (e.g. the I80 bus on the ESP32-S3), so draws are sent straight from
+    /// the framebuffer. Otherwise they are streamed through `stream_buffer_size` buffers, which must be set.
+    bool direct_dma;
+} rm690b0_framebuffer_config_t;
+
+/**
+ * @brief What the driver was set up with, see `esp_lcd_panel_rm690b0_get_panel_info()`
+ */
+typedef struct { // NOLINT(*-use-using)
+    int width;                 ///< Width from the vendor config, axes swapped as the panel is, or 0 if unknown
+    int height;                ///< Height, likewise
+    uint8_t bits_per_pixel;    ///< Current color depth
+    bool grayscale;            ///< 8 bpp is grayscale rather than color
+    size_t stream_buffer_size; ///< Size of each streaming buffer, or 0 without streaming
+    size_t num_fbs;            ///< Driver-owned framebuffers, or 0
+    int fb_width;              ///< Framebuffer width, if there are framebuffers
+    int fb_height;             ///< Framebuffer height
+} rm690b0_panel_info_t;
+
+/**
+ * @brief Creates a panel IO and panel at a given clock, and initializes the panel
+ *
+ * @param[in] clock_hz Clock to create the panel IO with, e.g. as `pclk_hz`
+ * @param[out] panel Returned panel handle
+ * @param[in] user_ctx User context from the calibration config
+ * @return ESP_OK if the panel is ready to draw
+ */
+typedef esp_err_t (*rm690b0_open_panel_cb_t)(uint32_t clock_hz, esp_lcd_panel_handle_t* panel, void* user_ctx);
+
+/**
+ * @brief Deletes a panel created by `rm690b0_open_panel_cb_t`, and its panel IO
+ */
+typedef void (*rm690b0_close_panel_cb_t)(esp_lcd_panel_handle_t panel, void* user_ctx);
+
+/**
+ * @brief Bus clock calibration, see `esp_lcd_panel_rm690b0_calibrate_clock()`
+ */
+typedef struct { // NOLINT(*-use-using)
+    uint32_t min_clock_hz; ///< Lowest clock to try, which should be known to work
+    uint32_t max_clock_hz; ///< Highest clock to try
+    uint32_t step_hz;      ///< Clock increment between tries
+    unsigned rounds;       ///< Test patterns written and read back at each clock, e.g. 8
+
+    rm690b0_open_panel_cb_t open_panel;   ///< Brings the panel up at a clock
+    rm690b0_close_panel_cb_t close_panel; ///< Tears it down again
+    void* user_ctx;                       ///< Passed to the callbacks
+
+    const char* nvs_namespace; ///< NVS namespace to store the result in, or NULL not to store it
+} rm690b0_clock_calibration_t;
+
+/**
+ * @brief Power state of the panel, from the commands the driver has sent
+ */
+typedef enum { // NOLINT(*-use-using)
+    RM690B0_POWER_ACTIVE,      ///< Awake, all rows and colors shown
+    RM690B0_POWER_IDLE,        ///< Awake, idle mode (8 colors)
+    RM690B0_POWER_PARTIAL,     ///< Awake, partial mode
+    RM690B0_POWER_DISPLAY_OFF, ///< Awake, display off
+    RM690B0_POWER_SLEEP,       ///< Asleep
+} rm690b0_power_state_t;
+
+/**
+ * @brief Power manager settings, see `esp_lcd_panel_rm690b0_enable_power_manager()`
+ */
+typedef struct { // NOLINT(*-use-using)
+    uint32_t auto_sleep_ms; ///< Put the panel to sleep after this long without draws, or 0 never to
+    bool hold_pm_lock;      ///< Hold an APB frequency lock while pixels are being sent
+} rm690b0_power_config_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Callback invoked when all pixels of an `esp_lcd_panel_draw_bitmap()` call have been sent
+ *
+ * @note  Runs in ISR context. It must be placed in IRAM and must not block.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] user_ctx User context passed to `esp_lcd_panel_rm690b0_register_event_callbacks()`
+ * @return Whether a higher priority task has been woken up by this function
+ */
+typedef bool (*esp_lcd_panel_rm690b0_color_done_cb_t)(esp_lcd_panel_handle_t panel, void* user_ctx);
+
+/**
+ * @brief Callback invoked whenever one color transfer to the panel IO is done
+ *
+ * A draw may be sent as several transfers, e.g. one per streaming band.
+ *
+ * @note  Runs in ISR context. It must be placed in IRAM and must not block.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] bytes Pixel bytes of the transfer
+ * @param[in] in_flight_bytes Pixel bytes of the transfers still queued in the panel IO
+ * @param[in] user_ctx User context passed to `esp_lcd_panel_rm690b0_register_event_callbacks()`
+ * @return Whether a higher priority task has been woken up by this function
+ */
+typedef bool (*esp_lcd_panel_rm690b0_transfer_done_cb_t)(esp_lcd_panel_handle_t panel, size_t bytes,
+                                                         size_t in_flight_bytes, void* user_ctx);
+
+/**
+ * @brief Driver event callbacks
+ */
+typedef struct { // NOLINT(*-use-using)
+    esp_lcd_panel_rm690b0_color_done_cb_t on_color_trans_done; ///< All pixels of a draw have been sent
+    esp_lcd_panel_rm690b0_transfer_done_cb_t on_transfer_done; ///< One transfer of a draw has been sent
+} rm690b0_event_callbacks_t;
+
+/**
+ * @brief Callback invoked when a pipelined flush is done with its buffer
+ *
+ * @note  Runs in ISR context, or in the transfer task if the flush failed or had nothing to send.
+ *        It must be placed in IRAM and must not block.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] color_data The buffer passed to `esp_lcd_panel_rm690b0_flush_async()`, which may be reused now
+ * @param[in] user_ctx User context passed to `esp_lcd_panel_rm690b0_start_pipeline()`
+ * @return Whether a higher priority task has been woken up by this function
+ */
+typedef bool (*esp_lcd_panel_rm690b0_flush_done_cb_t)(esp_lcd_panel_handle_t panel, const void* color_data,
+                                                      void* user_ctx);
+
+/**
+ * @brief Callback invoked when an asynchronous init or sleep sequence has finished
+ *
+ * @note  Runs in the esp_timer task. Keep it short and don't block.
+ *
+ * @param[in] panel Panel the sequence ran on
+ * @param[in] result ESP_OK if every step succeeded, otherwise the error returned by the failing step
+ * @param[in] user_ctx User context passed when the sequence was started
+ */
+typedef void (*esp_lcd_panel_rm690b0_done_cb_t)(esp_lcd_panel_handle_t panel, esp_err_t result, void* user_ctx);
+
+/**
+ * @brief Callback invoked on every TE pulse, i.e. at the start of the panel's vertical blanking period
+ *
+ * @note  Runs in ISR context. It must be placed in IRAM and must not block.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] timestamp_us `esp_timer_get_time()` at the TE pulse
+ * @param[in] user_ctx User context passed to `esp_lcd_panel_rm690b0_register_vsync_cb()`
+ * @return Whether a higher priority task has been woken up by this function
+ */
+typedef bool (*esp_lcd_panel_rm690b0_vsync_cb_t)(esp_lcd_panel_handle_t panel, int64_t timestamp_us, void* user_ctx);
+
 /**
  * @brief Create a panel for the RM690B0 AMOLED controller
  *
@@ -38,8 +334,872 @@ esp_err_t esp_lcd_new_panel_rm690b0(esp_lcd_panel_io_handle_t io,
 
 
 uint8_t esp_lcd_panel_rm690b0_get_brightness(const esp_lcd_panel_t* panel);
+
+/**
+ * @brief Set the display brightness
+ *
+ * Like every command the driver sends, this may be called from any task, even while another task is
+ * inside `esp_lcd_panel_draw_bitmap()`. Commands never land in the middle of a draw: if another task is
+ * using the bus, the command is queued and sent by that task as soon as it is done, and this returns
+ * without waiting. Only if the queue (16 commands) is full does the caller wait for the bus.
+ *
+ * @param[in] panel LCD panel handle
+ * @param[in] brightness 0 (darkest) to 255 (brightest)
+ * @return
+ *          - ESP_OK                on success, or once queued
+ *          - Otherwise, the panel IO's error. Errors of queued commands are only logged.
+ */
 esp_err_t esp_lcd_panel_rm690b0_set_brightness(const esp_lcd_panel_t* panel, uint8_t brightness);
 
+/**
+ * @brief Initialize the panel, skipping reset and init if it kept running, e.g. across deep sleep
+ *
+ * Reads RDDPM, RDDMADCTL and RDDCOLMOD. If the panel is out of sleep with the display on, only the
+ * orientation and pixel format are sent, and only where they differ from the configuration, and the
+ * brightness is read back. Otherwise, falls back to `esp_lcd_panel_reset()` and `esp_lcd_panel_init()`.
+ *
+ * @note  The panel IO must support `esp_lcd_panel_io_rx_param()`. Keep the RESET and EN pins high
+ *        through deep sleep (see `gpio_hold_en()`), or the panel will need a cold start anyway.
+ *
+ * @param[in] panel Panel handle
+ * @param[out] warm Set to whether the panel was warm started. May be NULL.
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if the panel is NULL or its pixel format is unsupported
+ *          - ESP_ERR_INVALID_STATE if an async sequence is in progress
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_warm_init(const esp_lcd_panel_t* panel, bool* warm);
+
+/**
+ * @brief Fade the brightness without blocking the calling task
+ *
+ * Steps every 10 ms from an esp_timer. Steps don't interrupt a draw, nor wait for its pixels in the esp_timer
+ * task: one that comes due while pixels are in flight waits for a later step or the next draw. Claims the panel
+ * IO's `on_color_trans_done` callback, as with `esp_lcd_panel_rm690b0_register_event_callbacks()`, to know
+ * when they are out.
+ * A new fade, or `esp_lcd_panel_rm690b0_set_brightness()`, cancels a fade in progress without
+ * calling its `done_cb`.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] target Brightness to end at
+ * @param[in] duration_ms Length of the fade. 0 sets the brightness at the next step.
+ * @param[in] curve How the brightness moves from the current value to `target`
+ * @param[in] done_cb Called from the esp_timer task once `target` has been sent. May be NULL.
+ * @param[in] user_ctx Passed to `done_cb`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel is NULL
+ *          - ESP_ERR_NO_MEM        if the fade timer couldn't be created
+ *          - ESP_OK                if the fade was started
+ */
+esp_err_t esp_lcd_panel_rm690b0_fade_brightness(const esp_lcd_panel_t* panel, uint8_t target, uint32_t duration_ms,
+                                                rm690b0_fade_curve_t curve, esp_lcd_panel_rm690b0_done_cb_t done_cb,
+                                                void* user_ctx);
+
+/**
+ * @brief Check whether a brightness fade is in progress
+ *
+ * @param[in] panel Panel handle
+ * @return true until the fade's last step has been sent
+ */
+bool esp_lcd_panel_rm690b0_is_fading(const esp_lcd_panel_t* panel);
+
+/**
+ * @brief Initialize the panel without blocking the calling task
+ *
+ * Runs the same sequence as `esp_lcd_panel_init()` (optionally preceded by `esp_lcd_panel_reset()`),
+ * but waits out the controller's delays on an esp_timer instead of sleeping. This takes about
+ * a second with a reset, so the caller can bring up other peripherals in the meantime.
+ *
+ * @note  Until `done_cb` is called, `esp_lcd_panel_init()`, `esp_lcd_panel_reset()` and
+ *        `esp_lcd_panel_draw_bitmap()` return ESP_ERR_INVALID_STATE.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] reset Toggle the reset line before sending the init sequence
+ * @param[in] done_cb Called when the sequence has finished. May be NULL.
+ * @param[in] user_ctx Passed to `done_cb`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if the panel is NULL or its pixel format is unsupported
+ *          - ESP_ERR_INVALID_STATE if another async sequence is in progress
+ *          - ESP_OK                if the sequence was started
+ */
+esp_err_t esp_lcd_panel_rm690b0_init_async(const esp_lcd_panel_t* panel, bool reset,
+                                           esp_lcd_panel_rm690b0_done_cb_t done_cb, void* user_ctx);
+
+/**
+ * @brief Enter or leave sleep mode without blocking the calling task
+ *
+ * Like `esp_lcd_panel_disp_sleep()`, but `done_cb` is called once the controller is ready
+ * for the next command (120 ms after leaving sleep, 5 ms after entering it).
+ *
+ * @param[in] panel Panel handle
+ * @param[in] sleep True to enter sleep mode, false to leave it
+ * @param[in] done_cb Called when the controller is ready. May be NULL.
+ * @param[in] user_ctx Passed to `done_cb`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if the panel is NULL
+ *          - ESP_ERR_INVALID_STATE if another async sequence is in progress
+ *          - ESP_OK                if the sequence was started
+ */
+esp_err_t esp_lcd_panel_rm690b0_sleep_async(const esp_lcd_panel_t* panel, bool sleep,
+                                            esp_lcd_panel_rm690b0_done_cb_t done_cb, void* user_ctx);
+
+/**
+ * @brief Check whether an asynchronous init or sleep sequence is still running
+ *
+ * @param[in] panel Panel handle
+ * @return true while a sequence started by `esp_lcd_panel_rm690b0_init_async()` or
+ *         `esp_lcd_panel_rm690b0_sleep_async()` has not yet finished
+ */
+bool esp_lcd_panel_rm690b0_is_busy(const esp_lcd_panel_t* panel);
+
+/**
+ * @brief Register driver event callbacks
+ *
+ * The driver takes over the panel IO's `on_color_trans_done` callback, since one draw may be
+ * sent as several transfers. `cbs->on_color_trans_done` is called once per draw, when the
+ * color buffer passed to `esp_lcd_panel_draw_bitmap()` may be reused, and `cbs->on_transfer_done`
+ * once per transfer. Either may be NULL.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] cbs Callbacks. Copied, so it doesn't need to outlive this call.
+ * @param[in] user_ctx Passed to the callbacks
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if a parameter is NULL
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_register_event_callbacks(const esp_lcd_panel_t* panel,
+                                                        const rm690b0_event_callbacks_t* cbs, void* user_ctx);
+
+/**
+ * @brief Make `esp_lcd_panel_draw_bitmap()` wait for a TE pulse before sending pixels
+ *
+ * This prevents tearing on full-screen animation: the pixel stream starts right after
+ * the controller has begun scanning out the previous frame, and stays ahead of the scan line.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] enable Whether to wait for TE
+ * @return
+ *          - ESP_ERR_INVALID_STATE if the vendor config didn't set up a TE pin
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_set_te_sync(const esp_lcd_panel_t* panel, bool enable);
+
+/**
+ * @brief Register a callback for TE pulses
+ *
+ * @param[in] panel Panel handle
+ * @param[in] vsync_cb Callback, or NULL to unregister
+ * @param[in] user_ctx Passed to `vsync_cb`
+ * @return
+ *          - ESP_ERR_INVALID_STATE if the vendor config didn't set up a TE pin
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_register_vsync_cb(const esp_lcd_panel_t* panel,
+                                                  esp_lcd_panel_rm690b0_vsync_cb_t vsync_cb, void* user_ctx);
+
+/**
+ * @brief Get the panel's refresh timing, measured from the TE pin
+ *
+ * Use this to line up a renderer's frame budget with the display: the next frame starts
+ * at about `last_te_time_us + period_us`.
+ *
+ * @param[in] panel Panel handle
+ * @param[out] timing Measured timing
+ * @return
+ *          - ESP_ERR_INVALID_STATE if the vendor config didn't set up a TE pin
+ *          - ESP_ERR_NOT_FINISHED  if fewer than two TE pulses have been seen, so there is no period yet
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_get_frame_timing(const esp_lcd_panel_t* panel, rm690b0_frame_timing_t* timing);
+
+/**
+ * @brief Get the controller's window alignment
+ *
+ * The RM690B0 only draws correctly if a window starts on a multiple of `x_align` columns and
+ * `y_align` rows, and spans a multiple of them, counted in controller coordinates (i.e. including the gap).
+ *
+ * @param[in] panel Panel handle
+ * @param[out] x_align Column granularity
+ * @param[out] y_align Row granularity
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if a parameter is NULL
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_get_alignment(const esp_lcd_panel_t* panel, int* x_align, int* y_align);
+
+/**
+ * @brief Grow an area to the controller's alignment, taking the current gap into account
+ *
+ * Coordinates follow `esp_lcd_panel_draw_bitmap()`: x_end and y_end are excluded.
+ * Useful as an LVGL invalidation rounder.
+ *
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if a parameter is NULL
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_align_area(const esp_lcd_panel_t* panel, int* x_start, int* y_start, int* x_end,
+                                           int* y_end);
+
+/**
+ * @brief Switch the panel's color depth at runtime
+ *
+ * Sends COLMOD and the matching pixel format option. Later draws, including their byte counts and
+ * streaming bands, use the new depth, and so does a later `esp_lcd_panel_init()`. Use it to drop to
+ * 16 bpp or 8 bpp grayscale while animating and go back to 24 bpp when idle.
+ *
+ * @note  18-bit pixels are 3 bytes each on the wire, each component in the top 6 bits (RM690B0_PIXEL_FORMAT_RGB666).
+ *        With `esp_lcd_panel_rm690b0_set_source_format()`, draws keep being converted from the source format,
+ *        so the renderer doesn't need to know about the switch.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] bits_per_pixel 3, 8, 16, 18 or 24
+ * @param[in] grayscale Use 8 bpp grayscale rather than 8 bpp color. Needs `bits_per_pixel` 8.
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if the depth is unsupported
+ *          - ESP_ERR_NOT_SUPPORTED if it doesn't suit format conversion or alignment, which are enabled
+ *          - ESP_ERR_INVALID_STATE if an async sequence or a batch is in progress
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_set_color_depth(const esp_lcd_panel_t* panel, uint8_t bits_per_pixel,
+                                                bool grayscale);
+
+/**
+ * @brief Let `esp_lcd_panel_draw_bitmap()` align windows itself
+ *
+ * With a framebuffer set, a draw whose window isn't aligned is grown to the controller's alignment.
+ * The caller's pixels are sent for the requested area, and the extra edge pixels are copied from
+ * `framebuffer`, which must hold what's currently on screen. Upper layers can then keep their
+ * invalidation areas tight.
+ *
+ * @note  Needs 8, 16, 18 or 24 bits per pixel, and streaming buffers (see `stream_buffer_size`) to assemble
+ *        the grown window in.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] framebuffer Full-screen framebuffer with rows `width` pixels apart, or NULL to stop aligning
+ * @param[in] width Framebuffer width in pixels
+ * @param[in] height Framebuffer height in pixels
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if the framebuffer size is invalid
+ *          - ESP_ERR_NOT_SUPPORTED if the pixel format isn't a whole number of bytes
+ *          - ESP_ERR_INVALID_STATE if streaming isn't enabled
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_set_align_framebuffer(const esp_lcd_panel_t* panel, const void* framebuffer,
+                                                      int width, int height);
+
+/**
+ * @brief Define the hardware scroll area (VSCRDEF)
+ *
+ * The controller scrolls along its frame memory lines: the panel's y axis, or its x axis with swapped axes.
+ * Counts are in lines along that axis, in the panel's orientation, and include the gap lines before the
+ * visible area. They should add up to the controller's number of lines. Mirroring is taken care of;
+ * swapping axes turns scrolling off, since the area would be along the other axis.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] top_fixed Lines before the scroll area that don't scroll
+ * @param[in] scroll_lines Lines in the scroll area
+ * @param[in] bottom_fixed Lines after the scroll area that don't scroll
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if the area is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_set_scroll_area(const esp_lcd_panel_t* panel, int top_fixed, int scroll_lines,
+                                                int bottom_fixed);
+
+/**
+ * @brief Scroll the scroll area's contents (VSCSAD)
+ *
+ * Costs two command bytes. The contents wrap around: the line that leaves the area at the start comes back
+ * in at the end. Draw the newly exposed lines where `esp_lcd_panel_rm690b0_scroll_map_line()` says.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] offset Lines to scroll by from the unscrolled position, towards lower coordinates. Wraps around.
+ * @return
+ *          - ESP_ERR_INVALID_STATE if no scroll area is set
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_scroll_to(const esp_lcd_panel_t* panel, int offset);
+
+/**
+ * @brief Find where to draw so that pixels show up on a given line while scrolled
+ *
+ * @param[in] panel Panel handle
+ * @param[in] line Line on screen, along the scroll axis (y, or x with swapped axes)
+ * @param[out] draw_line Coordinate to pass to `esp_lcd_panel_draw_bitmap()`. Same as `line` outside the scroll area.
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if an argument is NULL
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_scroll_map_line(const esp_lcd_panel_t* panel, int line, int* draw_line);
+
+/**
+ * @brief Show only some rows of the panel (PTLAR, PTLON), or all of them again (NORON)
+ *
+ * Rows outside the area are dark, which saves panel power. Draws are clipped to the area, so rows
+ * that wouldn't be shown aren't sent either. A draw entirely outside it sends nothing, and is reported
+ * done right away if the driver knows when transfers finish (with streaming or
+ * `esp_lcd_panel_rm690b0_register_event_callbacks()`); otherwise it is sent as usual.
+ *
+ * The rows are in panel coordinates, like a draw's, and stay on the same content when the panel is mirrored.
+ * That takes the panel height from the vendor config when y is mirrored.
+ *
+ * @note  Needs unswapped axes. Swapping them turns partial mode off.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] enable Enter partial mode, or go back to normal mode
+ * @param[in] y_start First row shown (ignored when disabling)
+ * @param[in] y_end Row after the last row shown, like `esp_lcd_panel_draw_bitmap()`'s y_end (ignored when disabling)
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if the area is invalid
+ *          - ESP_ERR_NOT_SUPPORTED if the axes are swapped
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_set_partial_mode(const esp_lcd_panel_t* panel, bool enable, int y_start, int y_end);
+
+/**
+ * @brief Enter or leave idle mode (IDMON, IDMOFF), which shows 8 colors only to save power
+ *
+ * @param[in] panel Panel handle
+ * @param[in] enable Enter idle mode, or leave it
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel is NULL
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_set_idle_mode(const esp_lcd_panel_t* panel, bool enable);
+
+/**
+ * @brief Get the partial and idle mode settings
+ *
+ * @param[in] panel Panel handle
+ * @param[out] partial Whether partial mode is on. May be NULL.
+ * @param[out] y_start First row of the partial area. May be NULL.
+ * @param[out] y_end Row after the partial area. May be NULL.
+ * @param[out] idle Whether idle mode is on. May be NULL.
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel is NULL
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_get_display_mode(const esp_lcd_panel_t* panel, bool* partial, int* y_start,
+                                                 int* y_end, bool* idle);
+
+/**
+ * @brief Let the driver handle sleep, and optionally hold the bus clock up while pixels are sent
+ *
+ * Once enabled:
+ *  - A draw on a sleeping panel sends SLPOUT first. Frame memory takes pixels while asleep, so the draw
+ *    only waits a few ms, not the 120 ms until the panel shows it.
+ *  - `esp_lcd_panel_disp_sleep()` doesn't block. SLPIN is sent from an esp_timer once the panel has been
+ *    awake for 120 ms, as the controller requires, and after the draw in progress.
+ *  - With `auto_sleep_ms`, the panel goes to sleep that long after the last draw.
+ *  - With `hold_pm_lock`, an ESP_PM_APB_FREQ_MAX lock is held from each transfer's submission until it is
+ *    done, so dynamic frequency scaling doesn't slow the bus down mid-frame. Claims the panel IO's
+ *    `on_color_trans_done` callback, as with `esp_lcd_panel_rm690b0_register_event_callbacks()`. Without
+ *    CONFIG_PM_ENABLE there is no lock to hold.
+ *
+ * May be called again to change the settings.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] config Power manager settings
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel or config is NULL
+ *          - ESP_ERR_NO_MEM        if the timer or lock can't be created
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_enable_power_manager(const esp_lcd_panel_t* panel,
+                                                     const rm690b0_power_config_t* config);
+
+/**
+ * @brief Get the panel's power state
+ *
+ * Sleep wins over display off, which wins over partial mode, which wins over idle mode.
+ *
+ * @param[in] panel Panel handle
+ * @return The power state
+ */
+rm690b0_power_state_t esp_lcd_panel_rm690b0_get_power_state(const esp_lcd_panel_t* panel);
+
+/**
+ * @brief Hold back commands so a set of changes reaches the panel together
+ *
+ * Until `esp_lcd_panel_rm690b0_cmd_batch_commit()`, commands from `esp_lcd_panel_swap_xy()`,
+ * `esp_lcd_panel_mirror()`, `esp_lcd_panel_invert_color()`, `esp_lcd_panel_disp_on_off()`,
+ * `esp_lcd_panel_rm690b0_set_brightness()`, `esp_lcd_panel_rm690b0_set_color_depth()` etc. are queued
+ * instead of sent. Register writes where only the last value matters (MADCTL, COLMOD, brightness,
+ * inversion) replace earlier ones, so e.g. a swap followed by a mirror sends MADCTL once.
+ * `esp_lcd_panel_set_gap()` sends nothing and takes effect at the next draw as usual.
+ *
+ * Only the calling task's commands are held back. The batch holds the bus until it is committed, so
+ * draws from other tasks wait for the commit and never see half of the changes, and their commands
+ * are sent after the batch's. If another task has a batch open, this waits until it is committed.
+ *
+ * @note  Draws from the task with the batch open return ESP_ERR_INVALID_STATE, and it must not wait
+ *        for other tasks' draws before committing. Up to 16 commands can be queued; beyond that,
+ *        calls return ESP_ERR_NO_MEM.
+ *
+ * @param[in] panel Panel handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel is NULL
+ *          - ESP_ERR_INVALID_STATE if the calling task already has a command batch open
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_cmd_batch_begin(const esp_lcd_panel_t* panel);
+
+/**
+ * @brief Send the commands queued since `esp_lcd_panel_rm690b0_cmd_batch_begin()`, back to back
+ *
+ * They go out under the bus claim taken by `esp_lcd_panel_rm690b0_cmd_batch_begin()`, which is then
+ * released, and stop at the first that fails.
+ *
+ * @param[in] panel Panel handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel is NULL
+ *          - ESP_ERR_INVALID_STATE if the calling task has no command batch open
+ *          - ESP_OK                on success
+ *          - The panel IO's error if a command couldn't be sent
+ */
+esp_err_t esp_lcd_panel_rm690b0_cmd_batch_commit(const esp_lcd_panel_t* panel);
+
+/**
+ * @brief Start collecting dirty rectangles for a frame
+ *
+ * Instead of calling `esp_lcd_panel_draw_bitmap()` for every small area, add the areas with
+ * `esp_lcd_panel_rm690b0_batch_add()` and send them with `esp_lcd_panel_rm690b0_batch_commit()`.
+ * Overlapping and nearby rectangles are merged when that is cheaper than paying for an extra window.
+ *
+ * @note  Needs 8, 16, 18 or 24 bits per pixel. Windows narrower than the framebuffer are gathered through
+ *        the streaming buffers (see `stream_buffer_size`). Without them, each row is its own transfer.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] config Batch configuration. Copied, but the framebuffer must stay valid until the commit has been sent.
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if a parameter is invalid
+ *          - ESP_ERR_NOT_SUPPORTED if the pixel format isn't a whole number of bytes
+ *          - ESP_ERR_INVALID_STATE if a batch is already open
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_batch_begin(const esp_lcd_panel_t* panel, const rm690b0_batch_config_t* config);
+
+/**
+ * @brief Add a dirty rectangle to the open batch
+ *
+ * Coordinates follow `esp_lcd_panel_draw_bitmap()`: x_end and y_end are excluded.
+ * The rectangle is grown to the controller's alignment and clipped to the framebuffer.
+ *
+ * @return
+ *          - ESP_ERR_INVALID_STATE if no batch is open
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_batch_add(const esp_lcd_panel_t* panel, int x_start, int y_start, int x_end,
+                                          int y_end);
+
+/**
+ * @brief Merge the batch's rectangles, send them and close the batch
+ *
+ * With TE sync enabled, waits for TE once per batch. A registered `on_color_trans_done`
+ * callback is called once, after the last window has been sent. An empty batch sends nothing,
+ * and calls it right away.
+ *
+ * @return
+ *          - ESP_ERR_INVALID_STATE if no batch is open
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_batch_commit(const esp_lcd_panel_t* panel);
+
+/**
+ * @brief Get the dirty-rectangle batching counters
+ *
+ * @param[in] panel Panel handle
+ * @param[out] stats Counters
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if a parameter is NULL
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_get_batch_stats(const esp_lcd_panel_t* panel, rm690b0_batch_stats_t* stats);
+
+/**
+ * @brief Size of one pixel in bytes
+ *
+ * @param[in] format Pixel format
+ * @return Bytes per pixel, or 0 if the format is unknown
+ */
+size_t esp_lcd_panel_rm690b0_pixel_format_size(rm690b0_pixel_format_t format);
+
+/**
+ * @brief Convert pixels from one format to another
+ *
+ * Any format can be converted to any other. Converting to GRAY8 uses BT.601 luma weights.
+ * The buffers must not overlap, unless both formats are the same size and `dst == src`. They need
+ * no particular alignment.
+ *
+ * @param[in] src_format Format of `src`
+ * @param[in] src Pixels to convert
+ * @param[in] dst_format Format of `dst`
+ * @param[out] dst Converted pixels. Must hold `pixel_count` pixels of `dst_format`.
+ * @param[in] pixel_count Number of pixels
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if a buffer is NULL
+ *          - ESP_ERR_NOT_SUPPORTED if a format is unknown
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_convert_pixels(rm690b0_pixel_format_t src_format, const void* src,
+                                               rm690b0_pixel_format_t dst_format, void* dst, size_t pixel_count);
+
+/**
+ * @brief Set the format of the pixels passed to `esp_lcd_panel_draw_bitmap()`
+ *
+ * If it differs from the panel's format, draws are converted on the fly while they are copied into
+ * the streaming buffers, so the renderer can keep one format whatever the panel's color depth.
+ *
+ * @note  Needs streaming buffers (see `stream_buffer_size`), and can't be combined with
+ *        `esp_lcd_panel_rm690b0_set_align_framebuffer()`. Dirty-rectangle batches are sent as-is,
+ *        so their framebuffer must be in the panel's format.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] format Format of the caller's pixels
+ * @return
+ *          - ESP_ERR_NOT_SUPPORTED if the panel's color depth has no matching conversion format (3 bpp, 8 bpp color)
+ *          - ESP_ERR_INVALID_STATE if streaming isn't enabled, or alignment is
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_set_source_format(const esp_lcd_panel_t* panel, rm690b0_pixel_format_t format);
+
+/**
+ * @brief Get flush instrumentation
+ *
+ * Counting is always on; it costs a few `esp_timer_get_time()` calls per flush. With SystemView tracing
+ * enabled (`CONFIG_APPTRACE_SV_ENABLE`), flushes and their phases are also traced as user events:
+ * 0 flush, 1 window setup, 2 TE wait, 3 queuing pixels.
+ *
+ * @param[in] panel Panel handle
+ * @param[out] stats Totals since the panel was created or the stats were last reset
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if an argument is NULL
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_get_stats(const esp_lcd_panel_t* panel, rm690b0_stats_t* stats);
+
+/**
+ * @brief Reset flush instrumentation
+ *
+ * Keeps `init_time_us`, so a benchmark can reset the stats after init.
+ *
+ * @param[in] panel Panel handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel is NULL
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_reset_stats(const esp_lcd_panel_t* panel);
+
+/**
+ * @brief Format stats as one line of JSON, e.g. to log benchmark results for regression tracking
+ *
+ * @param[in] stats Stats from `esp_lcd_panel_rm690b0_get_stats()`
+ * @param[out] buffer Output buffer. May be NULL if `size` is 0.
+ * @param[in] size Size of `buffer` in bytes
+ * @return Length of the full line, as for `snprintf()`, or -1 if an argument is invalid
+ */
+int esp_lcd_panel_rm690b0_format_stats(const rm690b0_stats_t* stats, char* buffer, size_t size);
+
+/**
+ * @brief Start a transfer task that sends flushes while the caller renders the next one
+ *
+ * `esp_lcd_panel_rm690b0_flush_async()` then only queues a flush and returns. The transfer task, pinned
+ * to its own core, runs the window setup, TE wait and pixel transfers, so rendering overlaps bus time.
+ * Give it at least two buffers to take turns with, e.g. the two draw buffers of LVGL.
+ *
+ * The driver takes over the panel IO's `on_color_trans_done` callback, as with
+ * `esp_lcd_panel_rm690b0_register_event_callbacks()`.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] config Pipeline configuration, or NULL for the defaults
+ * @param[in] done_cb Called when a flush's buffer may be reused. May be NULL.
+ * @param[in] user_ctx Passed to `done_cb`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel is NULL or `core_id` is neither a core, -1 nor tskNO_AFFINITY
+ *          - ESP_ERR_INVALID_STATE if the pipeline is already running
+ *          - ESP_ERR_NO_MEM        if the task or its queue can't be created
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_start_pipeline(const esp_lcd_panel_t* panel, const rm690b0_pipeline_config_t* config,
+                                               esp_lcd_panel_rm690b0_flush_done_cb_t done_cb, void* user_ctx);
+
+/**
+ * @brief Queue a draw for the transfer task
+ *
+ * Does what `esp_lcd_panel_draw_bitmap()` does, in the transfer task. Waits only if the queue is full.
+ * `color_data` must stay untouched until it is handed back to the pipeline's `done_cb`.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] x_start Start column, included
+ * @param[in] y_start Start row, included
+ * @param[in] x_end End column, excluded
+ * @param[in] y_end End row, excluded
+ * @param[in] color_data Pixels of the area
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel or color_data is NULL, or the area is empty or off the panel
+ *          - ESP_ERR_INVALID_STATE if the pipeline isn't running
+ *          - ESP_OK                once queued. Errors of the draw itself are logged.
+ */
+esp_err_t esp_lcd_panel_rm690b0_flush_async(const esp_lcd_panel_t* panel, int x_start, int y_start, int x_end,
+                                            int y_end, const void* color_data);
+
+/**
+ * @brief Stop the transfer task once it has sent all queued flushes
+ *
+ * Transfers of the last flush may still be on the wire when this returns; its buffer is handed
+ * back to `done_cb` as usual.
+ *
+ * @param[in] panel Panel handle
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel is NULL
+ *          - ESP_ERR_INVALID_STATE if the pipeline isn't running
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_stop_pipeline(const esp_lcd_panel_t* panel);
+
+/**
+ * @brief Draw like `esp_lcd_panel_draw_bitmap()`, unless that would block on earlier transfers
+ *
+ * The panel IO sends commands only once all queued color transfers are done, so a draw issued while
+ * transfers are in flight waits for them inside its window setup. This waits at most `timeout_ms` for
+ * them, and for other tasks' draws, then returns ESP_ERR_TIMEOUT without drawing anything. With a
+ * timeout of 0, it draws only if it can start right away. Once a draw has started, it can still wait
+ * for its own transfers, e.g. for a streaming buffer, or for TE with TE sync on. A fade step that is due
+ * goes out only once the earlier transfers are done, so it never makes the draw overrun its timeout.
+ *
+ * On first use, takes over the panel IO's `on_color_trans_done` callback, as with
+ * `esp_lcd_panel_rm690b0_register_event_callbacks()`.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] x_start Start column, included
+ * @param[in] y_start Start row, included
+ * @param[in] x_end End column, excluded
+ * @param[in] y_end End row, excluded
+ * @param[in] color_data Pixels, as for `esp_lcd_panel_draw_bitmap()`
+ * @param[in] timeout_ms How long to wait for the bus and for earlier transfers
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel or color_data is NULL, or the area is empty or off the panel
+ *          - ESP_ERR_TIMEOUT       if the draw would have had to wait longer
+ *          - Otherwise, as `esp_lcd_panel_draw_bitmap()`
+ */
+esp_err_t esp_lcd_panel_rm690b0_draw_bitmap_timeout(esp_lcd_panel_t* panel, int x_start, int y_start, int x_end,
+                                                    int y_end, const void* color_data, uint32_t timeout_ms);
+
+/**
+ * @brief Get the pixel bytes still queued in the panel IO
+ *
+ * Only counts transfers made while the driver owns the panel IO's `on_color_trans_done` callback, e.g.
+ * after `esp_lcd_panel_rm690b0_register_event_callbacks()`; 0 otherwise.
+ *
+ * @param[in] panel Panel handle
+ * @return Bytes submitted to the panel IO and not yet sent
+ */
+size_t esp_lcd_panel_rm690b0_get_in_flight_bytes(const esp_lcd_panel_t* panel);
+
+/**
+ * @brief A draw whose address window and byte count were worked out ahead of time
+ *
+ * Filled in by the C++ front end in `esp_lcd_rm690b0.hpp`, at compile time where it can.
+ */
+typedef struct { // NOLINT(*-use-using)
+    uint16_t x_start;       ///< First column, in controller coordinates: gap included
+    uint16_t y_start;       ///< First row, gap included
+    uint16_t x_end;         ///< Last column, *included*, gap included
+    uint16_t y_end;         ///< Last row, *included*, gap included
+    size_t size;            ///< Pixel bytes in the window
+    uint8_t bits_per_pixel; ///< Color depth the size was computed for
+    uint8_t x_gap;          ///< Column gap the window includes
+    uint8_t y_gap;          ///< Row gap the window includes
+} rm690b0_prepared_draw_t;
+
+/**
+ * @brief Draw a prepared window, like `esp_lcd_panel_draw_bitmap()` without the per-draw window and size math
+ *
+ * When partial mode, fill detection, alignment, source conversion or a driver-owned framebuffer is in play,
+ * the draw takes the usual `esp_lcd_panel_draw_bitmap()` path instead.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] draw Window and size of the draw
+ * @param[in] color_data Pixels, as for `esp_lcd_panel_draw_bitmap()`
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if a parameter is NULL, the window is inside out or starts in the gap, or `size`
+ *                                  isn't the window's byte count
+ *          - ESP_ERR_INVALID_STATE if the panel's color depth or gaps have changed since the draw was prepared
+ *          - Otherwise, as `esp_lcd_panel_draw_bitmap()`
+ */
+esp_err_t esp_lcd_panel_rm690b0_draw_prepared(esp_lcd_panel_t* panel, const rm690b0_prepared_draw_t* draw,
+                                              const void* color_data);
+
+/**
+ * @brief Check the link to the panel at its current clock
+ *
+ * Writes `rounds` test patterns (alternating bits, full swings and pseudo-random bytes) to a 32 x 8 pixel
+ * area in the top-left corner, and reads each back with `esp_lcd_panel_rm690b0_read_area()`.
+ * The area is left with the last pattern.
+ *
+ * @param[in] panel Panel handle, initialized
+ * @param[in] rounds Patterns to write and read back
+ * @param[out] bad_bytes Bytes that read back different from what was written
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if a parameter is NULL
+ *          - ESP_ERR_INVALID_STATE if partial mode, fill detection, alignment or source conversion is on
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - Otherwise, the panel IO's error
+ */
+esp_err_t esp_lcd_panel_rm690b0_test_link(esp_lcd_panel_t* panel, unsigned rounds, size_t* bad_bytes);
+
+/**
+ * @brief Find the highest bus clock the panel works at
+ *
+ * Brings the panel up at rising clocks, from `min_clock_hz` by `step_hz`, and runs
+ * `esp_lcd_panel_rm690b0_test_link()` at each. Stops at the first clock that fails, and returns the
+ * one below it. With `nvs_namespace` set, stores the result there for `esp_lcd_panel_rm690b0_load_clock()`.
+ *
+ * @note  Reads go over a single data line, at the same clock as writes. A panel whose reads fail before
+ *        its writes do is calibrated to the read limit, which errs on the safe side.
+ *
+ * @param[in] config Clock range and callbacks
+ * @param[out] clock_hz Highest clock at which every test pattern read back unchanged
+ * @return
+ *          - ESP_ERR_INVALID_ARG       if a parameter is invalid
+ *          - ESP_ERR_INVALID_RESPONSE  if patterns don't read back even at `min_clock_hz`
+ *          - Otherwise, the NVS error, if storing the result failed
+ */
+esp_err_t esp_lcd_panel_rm690b0_calibrate_clock(const rm690b0_clock_calibration_t* config, uint32_t* clock_hz);
+
+/**
+ * @brief Get the clock stored by `esp_lcd_panel_rm690b0_calibrate_clock()`
+ *
+ * @param[in] nvs_namespace NVS namespace the calibration stored it in
+ * @param[out] clock_hz Stored clock
+ * @return
+ *          - ESP_ERR_NVS_NOT_FOUND if no clock was stored yet
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_load_clock(const char* nvs_namespace, uint32_t* clock_hz);
+
+/**
+ * @brief Read an area of the panel's frame memory back
+ *
+ * Sends RAMRD, then RAMRDC, through the panel IO's `rx_param()`, reading the area in chunks of about
+ * 4 kB straight into `buffer`. Pixels come back in the panel's pixel format, as they were drawn.
+ * Waits for draws on other tasks to finish. For a screenshot without a full-size buffer, read
+ * the screen in bands of rows.
+ *
+ * The time taken shows up in the stats' readback figures, to weigh readback against keeping a
+ * framebuffer copy.
+ *
+ * @note  The panel IO must support `rx_param()` with parameters this large; check the SPI bus's
+ *        `max_transfer_sz`.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] x_start Start column, included
+ * @param[in] y_start Start row, included
+ * @param[in] x_end End column, excluded
+ * @param[in] y_end End row, excluded
+ * @param[out] buffer Receives the pixels, row by row
+ * @param[in] buffer_size Size of `buffer` in bytes
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel or buffer is NULL, or the area is empty
+ *          - ESP_ERR_INVALID_SIZE  if the buffer can't hold the area
+ *          - ESP_ERR_INVALID_STATE if an async sequence is running or a command batch is open
+ *          - Otherwise, the panel IO's error
+ */
+esp_err_t esp_lcd_panel_rm690b0_read_area(const esp_lcd_panel_t* panel, int x_start, int y_start, int x_end,
+                                          int y_end, void* buffer, size_t buffer_size);
+
+/**
+ * @brief Fill an area with one color, without a color buffer
+ *
+ * Sends the area as RAMWR and RAMWRC transfers, all from one small DMA buffer holding the color.
+ * Like a draw, it waits for TE if TE sync is on, is clipped to the partial area, and calls
+ * `on_color_trans_done` once all of it has been sent. The area should be aligned like any draw.
+ *
+ * The color goes out from a 4 kB buffer in internal RAM, allocated with the panel, so fills never
+ * allocate. On first use, takes over the panel IO's `on_color_trans_done` callback, as with
+ * `esp_lcd_panel_rm690b0_register_event_callbacks()`.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] x_start Start column, included
+ * @param[in] y_start Start row, included
+ * @param[in] x_end End column, excluded
+ * @param[in] y_end End row, excluded
+ * @param[in] color In the panel's pixel format: RGB565 at 16 bpp, 0xRRGGBB at 18 and 24 bpp (the top 6 bits
+ *                  of each byte at 18 bpp), and the gray level at 8 bpp
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel is NULL or the area is empty
+ *          - ESP_ERR_NOT_SUPPORTED at 3 bpp, whose pixels don't fill whole bytes
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_fill_rect(const esp_lcd_panel_t* panel, int x_start, int y_start, int x_end,
+                                          int y_end, uint32_t color);
+
+/**
+ * @brief Send draws of a single color like `esp_lcd_panel_rm690b0_fill_rect()`
+ *
+ * With detection on, `esp_lcd_panel_draw_bitmap()` first checks whether all pixels of the draw are
+ * the same, stopping at the first one that differs. A clear then costs a scan of the buffer instead
+ * of a transfer of it. Draws from the driver's framebuffers are never checked, nor are draws at 3 bpp,
+ * e.g. after a change of color depth.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] enable Whether to check draws
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if panel is NULL
+ *          - ESP_ERR_NOT_SUPPORTED if enabling at 3 bpp, whose pixels don't fill whole bytes
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_set_fill_detection(const esp_lcd_panel_t* panel, bool enable);
+
+/**
+ * @brief Allocate full-size framebuffers in PSRAM, owned by the driver
+ *
+ * The framebuffers are aligned to the PSRAM cache line, in the panel's pixel format at the time of the
+ * call. Passing one of them to `esp_lcd_panel_draw_bitmap()` or `esp_lcd_panel_rm690b0_flush_async()`
+ * sends the given area of that framebuffer, with rows a framebuffer width apart: draw into one while
+ * another is on the wire, then hand it over, as with `esp_lcd_rgb_panel`. With `direct_dma`, the
+ * driver writes the area back from the cache and the DMA reads it from PSRAM, without a copy.
+ * The registered `on_color_trans_done` callback tells when a framebuffer is free again.
+ *
+ * As long as the framebuffers exist, the color depth can't change. Framebuffer draws are not
+ * converted from the source format. They are freed with the panel.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] config Framebuffer configuration
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if an argument is NULL or invalid
+ *          - ESP_ERR_INVALID_STATE if framebuffers already exist, or neither DMA nor streaming can send them
+ *          - ESP_ERR_NO_MEM        if out of PSRAM
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_create_framebuffers(const esp_lcd_panel_t* panel,
+                                                   const rm690b0_framebuffer_config_t* config);
+
+/**
+ * @brief Get one of the driver's framebuffers
+ *
+ * @param[in] panel Panel handle
+ * @param[in] index Framebuffer index, below `num_fbs`
+ * @param[out] framebuffer Returned framebuffer
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if an argument is NULL, or there is no such framebuffer
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_get_framebuffer(const esp_lcd_panel_t* panel, size_t index, void** framebuffer);
+
+/**
+ * @brief Get the panel's size, color depth, streaming and framebuffer setup
+ *
+ * For code layered on the driver, e.g. the LVGL adapter, to size its buffers.
+ *
+ * @param[in] panel Panel handle
+ * @param[out] info Returned information
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if an argument is NULL
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_get_panel_info(const esp_lcd_panel_t* panel, rm690b0_panel_info_t* info);
+
 #ifdef __cplusplus
 }
 #endif
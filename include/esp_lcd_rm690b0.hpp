@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_rm690b0.h"
+
+/**
+ * @brief RM690B0 panel whose geometry, color depth and gaps are fixed at compile time
+ *
+ * Windows and byte counts are worked out here, as constants for the `draw<...>()` overload,
+ * and draws go through `esp_lcd_panel_rm690b0_draw_prepared()`. The panel is a regular esp_lcd
+ * panel underneath: `handle()` works with the C API, including `esp_lcd_panel_draw_bitmap()`.
+ *
+ * Don't change the color depth or gaps on `handle()`; draws would fail with ESP_ERR_INVALID_STATE.
+ *
+ * @tparam Width Width in pixels
+ * @tparam Height Height in pixels
+ * @tparam Bpp Color depth: 8, 16, 18 or 24
+ * @tparam XGap Column gap, as for `esp_lcd_panel_set_gap()`
+ * @tparam YGap Row gap
+ */
+template <int Width, int Height, uint8_t Bpp, int XGap = 0, int YGap = 0>
+class RM690B0 {
+    static_assert(Width > 0 && Height > 0, "empty panel");
+    static_assert(Bpp == 8 || Bpp == 16 || Bpp == 18 || Bpp == 24, "unsupported color depth"); // NOLINT
+    static_assert(XGap >= 0 && XGap <= UINT8_MAX && YGap >= 0 && YGap <= UINT8_MAX, "gap out of range");
+    static_assert(Width + XGap <= UINT16_MAX && Height + YGap <= UINT16_MAX, "panel too large");
+
+public:
+    static constexpr int width = Width;
+    static constexpr int height = Height;
+    static constexpr uint8_t bits_per_pixel = Bpp;
+
+    /// Bytes per pixel on the wire. 18 bpp pixels take 3 bytes, like 24 bpp ones.
+    static constexpr size_t pixel_size = Bpp == 18 ? 3 : Bpp / 8; // NOLINT(*-magic-numbers)
+    static constexpr size_t row_bytes = pixel_size * Width;
+    static constexpr size_t frame_bytes = row_bytes * Height;
+
+    /// Bytes of an area `columns` wide and `rows` high
+    static constexpr size_t area_bytes(const int columns, const int rows) {
+        return pixel_size * static_cast<size_t>(columns) * static_cast<size_t>(rows);
+    }
+
+    /// Prepared draw of an area in panel coordinates, end excluded as in the esp_lcd API
+    static constexpr rm690b0_prepared_draw_t prepare(const int x_start, const int y_start, const int x_end,
+                                                     const int y_end) {
+        return {
+            .x_start = static_cast<uint16_t>(x_start + XGap),
+            .y_start = static_cast<uint16_t>(y_start + YGap),
+            .x_end = static_cast<uint16_t>(x_end + XGap - 1),
+            .y_end = static_cast<uint16_t>(y_end + YGap - 1),
+            .size = area_bytes(x_end - x_start, y_end - y_start),
+            .bits_per_pixel = Bpp,
+            .x_gap = XGap,
+            .y_gap = YGap,
+        };
+    }
+
+    /**
+     * @brief Create the panel with `esp_lcd_new_panel_rm690b0()`, then set its gaps
+     *
+     * @param[in] io panel IO handle
+     * @param[in] config general panel device configuration. Its `bits_per_pixel` is replaced by `Bpp`.
+     * @param[out] panel Receives the panel
+     * @return As `esp_lcd_new_panel_rm690b0()` and `esp_lcd_panel_set_gap()`
+     */
+    static esp_err_t create(const esp_lcd_panel_io_handle_t io, esp_lcd_panel_dev_config_t config,
+                            RM690B0& panel) {
+        config.bits_per_pixel = Bpp;
+
+        esp_lcd_panel_handle_t handle = nullptr;
+        esp_err_t ret = esp_lcd_new_panel_rm690b0(io, &config, &handle);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+
+        ret = esp_lcd_panel_set_gap(handle, XGap, YGap);
+        if (ret != ESP_OK) {
+            esp_lcd_panel_del(handle);
+            return ret;
+        }
+
+        panel = RM690B0(handle);
+        return ESP_OK;
+    }
+
+    RM690B0() = default;
+
+    RM690B0(const RM690B0&) = delete;
+    RM690B0& operator=(const RM690B0&) = delete;
+
+    RM690B0(RM690B0&& other) noexcept : panel(std::exchange(other.panel, nullptr)) {}
+
+    RM690B0& operator=(RM690B0&& other) noexcept {
+        if (this != &other) {
+            reset();
+            panel = std::exchange(other.panel, nullptr);
+        }
+
+        return *this;
+    }
+
+    ~RM690B0() { reset(); }
+
+    /// The esp_lcd panel, for the C API. Still owned by this object.
+    [[nodiscard]] esp_lcd_panel_handle_t handle() const { return panel; }
+
+    /// Draw an area, as `esp_lcd_panel_draw_bitmap()`. ESP_ERR_INVALID_ARG if it is empty or not on the panel.
+    esp_err_t draw(const int x_start, const int y_start, const int x_end, const int y_end,
+                   const void* color_data) const {
+        if (x_start < 0 || y_start < 0 || x_start >= x_end || y_start >= y_end || x_end > Width || y_end > Height) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        const rm690b0_prepared_draw_t prepared = prepare(x_start, y_start, x_end, y_end);
+        return esp_lcd_panel_rm690b0_draw_prepared(panel, &prepared, color_data);
+    }
+
+    /// Draw an area known at compile time: its window and size are constants
+    template <int XStart, int YStart, int XEnd, int YEnd>
+    esp_err_t draw(const void* color_data) const {
+        static_assert(XStart >= 0 && YStart >= 0 && XEnd <= Width && YEnd <= Height, "area outside the panel");
+        static_assert(XStart < XEnd && YStart < YEnd, "empty area");
+
+        static constexpr rm690b0_prepared_draw_t prepared = prepare(XStart, YStart, XEnd, YEnd);
+        return esp_lcd_panel_rm690b0_draw_prepared(panel, &prepared, color_data);
+    }
+
+    /// Draw the whole screen
+    esp_err_t draw_frame(const void* color_data) const { return draw<0, 0, Width, Height>(color_data); }
+
+private:
+    explicit RM690B0(const esp_lcd_panel_handle_t panel) : panel(panel) {}
+
+    void reset() {
+        if (panel) {
+            esp_lcd_panel_del(panel);
+            panel = nullptr;
+        }
+    }
+
+    esp_lcd_panel_handle_t panel = nullptr;
+};
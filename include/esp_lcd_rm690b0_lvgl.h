@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "esp_err.h"
+#include "esp_lcd_types.h"
+#include "lvgl.h"
+
+#if LVGL_VERSION_MAJOR < 9
+#error "The RM690B0 LVGL adapter needs LVGL 9"
+#endif
+
+/**
+ * @brief LVGL display settings, see `esp_lcd_panel_rm690b0_lvgl_create()`
+ */
+typedef struct { // NOLINT(*-use-using)
+    int hor_res; ///< Horizontal resolution, or 0 for the vendor config's `width`, axes swapped as the panel is
+    int ver_res; ///< Vertical resolution, or 0 for the vendor config's `height`
+
+    /// LV_DISPLAY_RENDER_MODE_PARTIAL renders into draw buffers allocated here. DIRECT and FULL render into the
+    /// driver's framebuffers (see `esp_lcd_panel_rm690b0_create_framebuffers()`), which must exist.
+    lv_display_render_mode_t render_mode;
+
+    /// Partial mode: rows per draw buffer, or 0 for a tenth of the screen. Rounded up to the row alignment.
+    size_t buffer_rows;
+    bool single_buffer; ///< Partial mode: one draw buffer rather than two, rendering waits for each flush
+} rm690b0_lvgl_config_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create an LVGL display drawing to the panel
+ *
+ * The display:
+ *  - Takes the panel's color depth: L8 at 8 bpp grayscale, RGB565 at 16 bpp, RGB888 at 18 and 24 bpp. LVGL's
+ *    RGB888 is blue first in memory, so set `rgb_ele_order` to LCD_RGB_ELEMENT_ORDER_BGR at 18 and 24 bpp.
+ *    LVGL has no format for 8 bpp color.
+ *  - Grows invalidated areas to the controller's alignment, so windows never need fixing up by the driver.
+ *  - Calls `lv_display_flush_ready()` when a flush's last pixel is on the wire, from the driver's transfer-done
+ *    callback: LVGL renders into one buffer while the other is being sent. This takes over the callbacks of
+ *    `esp_lcd_panel_rm690b0_register_event_callbacks()`.
+ *  - In partial mode, puts its draw buffers in internal DMA-capable RAM, so pixels go straight from them. If
+ *    that is short and the panel streams (see `stream_buffer_size`), they go to PSRAM instead, and the driver
+ *    sends them through its streaming buffers.
+ *  - In direct and full mode, renders straight into the driver's framebuffers: a flush sends the changed
+ *    area of the framebuffer, without a copy with `direct_dma`. Uses the first two framebuffers.
+ *
+ * Delete it with `lv_display_delete()`, before the panel. Its draw buffers go with it.
+ *
+ * @param[in] panel Panel handle
+ * @param[in] config Display settings
+ * @param[out] display Returned display
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if an argument is NULL or invalid
+ *          - ESP_ERR_NOT_SUPPORTED if LVGL has no color format for the panel's color depth, e.g. 8 bpp color
+ *          - ESP_ERR_INVALID_STATE if direct or full mode is asked for without framebuffers of the display's size
+ *          - ESP_ERR_NO_MEM        if out of memory
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_rm690b0_lvgl_create(esp_lcd_panel_handle_t panel, const rm690b0_lvgl_config_t* config,
+                                            lv_display_t** display);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <array>
+#include <memory>
+
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_rm690b0.h"
+#include "esp_lcd_rm690b0_lvgl.h"
+#include "esp_log.h"
+
+constexpr auto TAG = "panel.rm690b0";
+
+namespace {
+    constexpr size_t default_rows_divisor = 10; // Partial mode draws a tenth of the screen at a time
+
+    struct HeapCapsDeleter {
+        void operator()(void* ptr) const noexcept {
+            heap_caps_free(ptr);
+        }
+    };
+
+    using DrawBuffer = std::unique_ptr<uint8_t, HeapCapsDeleter>;
+
+    // What the adapter keeps for a display, freed along with it
+    struct LvglDisplay {
+        esp_lcd_panel_handle_t panel = nullptr;
+        int width = 0;
+        int height = 0;
+        std::array<DrawBuffer, 2> buffers; // Partial mode only: direct and full mode draw into the driver's
+    };
+
+    // NOLINTBEGIN(*-magic-numbers)
+    // 8 bpp color has no LVGL format, only 8 bpp grayscale does
+    lv_color_format_t color_format(const rm690b0_panel_info_t& info) {
+        switch (info.bits_per_pixel) {
+        case 8:
+            return info.grayscale ? LV_COLOR_FORMAT_L8 : LV_COLOR_FORMAT_UNKNOWN;
+
+        case 16:
+            return LV_COLOR_FORMAT_RGB565;
+
+        case 18: // Sent as 3 bytes per pixel, the controller drops the bottom 2 bits of each
+        case 24:
+            return LV_COLOR_FORMAT_RGB888;
+
+        default:
+            return LV_COLOR_FORMAT_UNKNOWN;
+        }
+    }
+
+    // NOLINTEND(*-magic-numbers)
+
+    // The last pixel of the flush is on the wire, so LVGL may render into its buffer again
+    IRAM_ATTR bool on_flush_done([[maybe_unused]] esp_lcd_panel_handle_t panel, void* user_ctx) {
+        lv_display_flush_ready(static_cast<lv_display_t*>(user_ctx));
+        return false;
+    }
+
+    // In direct and full mode, px_map is the start of the framebuffer, which the driver recognizes: it sends
+    // the area of the framebuffer rather than px_map's first pixels.
+    void flush(lv_display_t* display, const lv_area_t* area, uint8_t* px_map) {
+        const auto* state = static_cast<const LvglDisplay*>(lv_display_get_driver_data(display));
+
+        if (const esp_err_t ret = esp_lcd_panel_draw_bitmap(state->panel, area->x1, area->y1, area->x2 + 1,
+                                                            area->y2 + 1, px_map);
+            ret != ESP_OK) {
+            ESP_LOGE(TAG, "LVGL flush failed: %s", esp_err_to_name(ret));
+            lv_display_flush_ready(display); // Nothing will call back for it
+        }
+    }
+
+    // Grow an invalidated area to the controller's alignment, but not past the screen. LVGL has already
+    // clipped it to the screen, whose size is aligned, so clamping never undoes the rounding.
+    void round_area(lv_event_t* event) {
+        const auto* state = static_cast<const LvglDisplay*>(lv_event_get_user_data(event));
+        auto* area = static_cast<lv_area_t*>(lv_event_get_param(event));
+
+        int x_start = area->x1;
+        int y_start = area->y1;
+        int x_end = area->x2 + 1;
+        int y_end = area->y2 + 1;
+        esp_lcd_panel_rm690b0_align_area(state->panel, &x_start, &y_start, &x_end, &y_end);
+
+        area->x1 = std::max(x_start, 0);
+        area->y1 = std::max(y_start, 0);
+        area->x2 = std::min(x_end, state->width) - 1;
+        area->y2 = std::min(y_end, state->height) - 1;
+    }
+
+    void delete_display(lv_event_t* event) {
+        auto* state = static_cast<LvglDisplay*>(lv_event_get_user_data(event));
+
+        // No more flush_ready calls for a display that is going away
+        const rm690b0_event_callbacks_t no_callbacks = {};
+        esp_lcd_panel_rm690b0_register_event_callbacks(state->panel, &no_callbacks, nullptr);
+
+        delete state; // NOLINT(*-owning-memory)
+    }
+
+    // Draw buffers for partial mode. Internal DMA-capable RAM sends without a copy; PSRAM only works through
+    // the driver's streaming buffers.
+    esp_err_t allocate_draw_buffers(LvglDisplay& state, const rm690b0_panel_info_t& info, const size_t count,
+                                    const size_t size) {
+        const bool psram_ok = info.stream_buffer_size != 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            DrawBuffer& buffer = state.buffers.at(i);
+
+            buffer.reset(static_cast<uint8_t*>(
+                heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL)));
+            if (!buffer && psram_ok) {
+                ESP_LOGD(TAG, "No internal RAM for LVGL draw buffer %zu, streaming it from PSRAM", i);
+                buffer.reset(static_cast<uint8_t*>(
+                    heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)));
+            }
+
+            ESP_RETURN_ON_FALSE(buffer, ESP_ERR_NO_MEM, TAG, "no memory for LVGL draw buffer %zu", i);
+        }
+
+        return ESP_OK;
+    }
+}
+
+esp_err_t esp_lcd_panel_rm690b0_lvgl_create(esp_lcd_panel_handle_t panel, const rm690b0_lvgl_config_t* config,
+                                            lv_display_t** display) {
+    ESP_RETURN_ON_FALSE(panel && config && display, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    rm690b0_panel_info_t info{};
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_rm690b0_get_panel_info(panel, &info), TAG, // NOLINT
+                        "Failed to get panel info");
+
+    const lv_color_format_t format = color_format(info);
+    ESP_RETURN_ON_FALSE(format != LV_COLOR_FORMAT_UNKNOWN, ESP_ERR_NOT_SUPPORTED, TAG,
+                        "no LVGL color format for %u bpp%s", info.bits_per_pixel, info.grayscale ? " grayscale" : "");
+
+    const bool partial = config->render_mode == LV_DISPLAY_RENDER_MODE_PARTIAL;
+    auto state = std::make_unique<LvglDisplay>();
+    state->panel = panel;
+    state->width = config->hor_res ? config->hor_res : info.width;
+    state->height = config->ver_res ? config->ver_res : info.height;
+    ESP_RETURN_ON_FALSE(state->width > 0 && state->height > 0, ESP_ERR_INVALID_ARG, TAG,
+                        "resolution neither given nor in the vendor config");
+
+    // Draw buffers hold whole aligned rows; round_area takes care of the columns
+    int x_align = 1;
+    int y_align = 1;
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_rm690b0_get_alignment(panel, &x_align, &y_align), TAG, // NOLINT
+                        "Failed to get alignment");
+
+    const size_t row_bytes = static_cast<size_t>(state->width) * lv_color_format_get_size(format);
+    std::array<void*, 2> buffers{};
+    size_t buffer_size = 0;
+
+    if (partial) {
+        const size_t rows = config->buffer_rows ? config->buffer_rows : state->height / default_rows_divisor;
+        const size_t aligned_rows = std::min<size_t>((std::max<size_t>(rows, 1) + y_align - 1) / y_align * y_align,
+                                                     state->height);
+        const size_t count = config->single_buffer ? 1 : 2;
+
+        buffer_size = aligned_rows * row_bytes;
+        ESP_RETURN_ON_ERROR(allocate_draw_buffers(*state, info, count, buffer_size), TAG, // NOLINT
+                            "Failed to allocate LVGL draw buffers");
+
+        for (size_t i = 0; i < count; ++i) {
+            buffers.at(i) = state->buffers.at(i).get();
+        }
+    } else {
+        ESP_RETURN_ON_FALSE(info.num_fbs && info.fb_width == state->width && info.fb_height == state->height,
+                            ESP_ERR_INVALID_STATE, TAG, "direct and full mode need framebuffers of the display's size");
+
+        for (size_t i = 0; i < std::min<size_t>(info.num_fbs, buffers.size()); ++i) {
+            ESP_RETURN_ON_ERROR(esp_lcd_panel_rm690b0_get_framebuffer(panel, i, &buffers.at(i)), TAG, // NOLINT
+                                "Failed to get framebuffer %zu", i);
+        }
+
+        buffer_size = state->height * row_bytes;
+    }
+
+    lv_display_t* lv_display = lv_display_create(state->width, state->height);
+    ESP_RETURN_ON_FALSE(lv_display, ESP_ERR_NO_MEM, TAG, "no memory for LVGL display");
+
+    const rm690b0_event_callbacks_t callbacks = {
+        .on_color_trans_done = on_flush_done,
+    };
+
+    if (const esp_err_t ret = esp_lcd_panel_rm690b0_register_event_callbacks(panel, &callbacks, lv_display);
+        ret != ESP_OK) {
+        lv_display_delete(lv_display);
+        ESP_LOGE(TAG, "Failed to register flush-done callback: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    lv_display_set_color_format(lv_display, format);
+    lv_display_set_buffers(lv_display, buffers[0], buffers[1], buffer_size, config->render_mode);
+    lv_display_set_flush_cb(lv_display, flush);
+
+    // Full mode always sends the whole screen, which is aligned already
+    if (config->render_mode != LV_DISPLAY_RENDER_MODE_FULL) {
+        lv_display_add_event_cb(lv_display, round_area, LV_EVENT_INVALIDATE_AREA, state.get());
+    }
+
+    // The display owns the state from here on
+    lv_display_set_driver_data(lv_display, state.get());
+    lv_display_add_event_cb(lv_display, delete_display, LV_EVENT_DELETE, state.release());
+
+    ESP_LOGD(TAG, "LVGL display %dx%d, %zu byte buffers", lv_display_get_horizontal_resolution(lv_display),
+             lv_display_get_vertical_resolution(lv_display), buffer_size);
+
+    *display = lv_display;
+    return ESP_OK;
+}
@@ -0,0 +1,213 @@
+#include <cstring>
+
+#include "esp_check.h"
+#include "esp_err.h"
+#include "esp_lcd_rm690b0.h"
+
+constexpr auto TAG = "panel.rm690b0";
+
+namespace {
+    struct RGB {
+        uint8_t r;
+        uint8_t g;
+        uint8_t b;
+    };
+
+    // One codec per pixel format: its size in bytes, and how to load and store a pixel as 8-bit RGB.
+    // Pixels may sit at any address; memcpy lets the compiler pick the widest access that is safe there.
+    // NOLINTBEGIN(*-magic-numbers)
+    template <rm690b0_pixel_format_t Format>
+    struct PixelCodec;
+
+    template <>
+    struct PixelCodec<RM690B0_PIXEL_FORMAT_RGB565> {
+        static constexpr size_t size = 2;
+
+        static RGB load(const uint8_t* src) {
+            uint16_t value;
+            std::memcpy(&value, src, size);
+
+            const uint8_t r = value >> 11 & 0x1F;
+            const uint8_t g = value >> 5 & 0x3F;
+            const uint8_t b = value & 0x1F;
+
+            // Replicate the top bits into the bottom ones, so full intensity stays full intensity
+            return {
+                static_cast<uint8_t>(r << 3 | r >> 2),
+                static_cast<uint8_t>(g << 2 | g >> 4),
+                static_cast<uint8_t>(b << 3 | b >> 2),
+            };
+        }
+
+        static void store(uint8_t* dst, const RGB color) {
+            const uint16_t value = (color.r & 0xF8) << 8 | (color.g & 0xFC) << 3 | color.b >> 3;
+            std::memcpy(dst, &value, size);
+        }
+    };
+
+    template <>
+    struct PixelCodec<RM690B0_PIXEL_FORMAT_RGB666> {
+        static constexpr size_t size = 3;
+
+        // The bottom two bits of each byte aren't part of the color, so replace them with its top ones
+        static RGB load(const uint8_t* src) {
+            return {
+                static_cast<uint8_t>((src[0] & 0xFC) | src[0] >> 6),
+                static_cast<uint8_t>((src[1] & 0xFC) | src[1] >> 6),
+                static_cast<uint8_t>((src[2] & 0xFC) | src[2] >> 6),
+            };
+        }
+
+        static void store(uint8_t* dst, const RGB color) {
+            dst[0] = color.r & 0xFC;
+            dst[1] = color.g & 0xFC;
+            dst[2] = color.b & 0xFC;
+        }
+    };
+
+    template <>
+    struct PixelCodec<RM690B0_PIXEL_FORMAT_RGB888> {
+        static constexpr size_t size = 3;
+
+        static RGB load(const uint8_t* src) {
+            return {src[0], src[1], src[2]};
+        }
+
+        static void store(uint8_t* dst, const RGB color) {
+            dst[0] = color.r;
+            dst[1] = color.g;
+            dst[2] = color.b;
+        }
+    };
+
+    template <>
+    struct PixelCodec<RM690B0_PIXEL_FORMAT_ARGB8888> {
+        static constexpr size_t size = 4;
+
+        static RGB load(const uint8_t* src) {
+            uint32_t value;
+            std::memcpy(&value, src, size);
+
+            return {
+                static_cast<uint8_t>(value >> 16),
+                static_cast<uint8_t>(value >> 8),
+                static_cast<uint8_t>(value),
+            };
+        }
+
+        static void store(uint8_t* dst, const RGB color) {
+            const uint32_t value = 0xFF000000U | color.r << 16 | color.g << 8 | color.b;
+            std::memcpy(dst, &value, size);
+        }
+    };
+
+    template <>
+    struct PixelCodec<RM690B0_PIXEL_FORMAT_GRAY8> {
+        static constexpr size_t size = 1;
+
+        static RGB load(const uint8_t* src) {
+            return {src[0], src[0], src[0]};
+        }
+
+        // BT.601 luma in 8-bit fixed point
+        static void store(uint8_t* dst, const RGB color) {
+            dst[0] = static_cast<uint8_t>((color.r * 77 + color.g * 150 + color.b * 29) >> 8);
+        }
+    };
+
+    // NOLINTEND(*-magic-numbers)
+
+    template <rm690b0_pixel_format_t Src, rm690b0_pixel_format_t Dst>
+    void convert(const uint8_t* src, uint8_t* dst, const size_t pixel_count) {
+        if constexpr (Src == Dst) {
+            if (dst != src) {
+                std::memcpy(dst, src, pixel_count * PixelCodec<Src>::size);
+            }
+        } else {
+            for (size_t i = 0; i < pixel_count; ++i) {
+                PixelCodec<Dst>::store(dst, PixelCodec<Src>::load(src));
+                src += PixelCodec<Src>::size;
+                dst += PixelCodec<Dst>::size;
+            }
+        }
+    }
+
+    template <rm690b0_pixel_format_t Src>
+    esp_err_t convert_from(const uint8_t* src, const rm690b0_pixel_format_t dst_format, uint8_t* dst,
+                           const size_t pixel_count) {
+        switch (dst_format) {
+        case RM690B0_PIXEL_FORMAT_RGB565:
+            convert<Src, RM690B0_PIXEL_FORMAT_RGB565>(src, dst, pixel_count);
+            return ESP_OK;
+
+        case RM690B0_PIXEL_FORMAT_RGB666:
+            convert<Src, RM690B0_PIXEL_FORMAT_RGB666>(src, dst, pixel_count);
+            return ESP_OK;
+
+        case RM690B0_PIXEL_FORMAT_RGB888:
+            convert<Src, RM690B0_PIXEL_FORMAT_RGB888>(src, dst, pixel_count);
+            return ESP_OK;
+
+        case RM690B0_PIXEL_FORMAT_ARGB8888:
+            convert<Src, RM690B0_PIXEL_FORMAT_ARGB8888>(src, dst, pixel_count);
+            return ESP_OK;
+
+        case RM690B0_PIXEL_FORMAT_GRAY8:
+            convert<Src, RM690B0_PIXEL_FORMAT_GRAY8>(src, dst, pixel_count);
+            return ESP_OK;
+
+        default:
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+    }
+}
+
+size_t esp_lcd_panel_rm690b0_pixel_format_size(rm690b0_pixel_format_t format) {
+    switch (format) {
+    case RM690B0_PIXEL_FORMAT_RGB565:
+        return PixelCodec<RM690B0_PIXEL_FORMAT_RGB565>::size;
+
+    case RM690B0_PIXEL_FORMAT_RGB666:
+        return PixelCodec<RM690B0_PIXEL_FORMAT_RGB666>::size;
+
+    case RM690B0_PIXEL_FORMAT_RGB888:
+        return PixelCodec<RM690B0_PIXEL_FORMAT_RGB888>::size;
+
+    case RM690B0_PIXEL_FORMAT_ARGB8888:
+        return PixelCodec<RM690B0_PIXEL_FORMAT_ARGB8888>::size;
+
+    case RM690B0_PIXEL_FORMAT_GRAY8:
+        return PixelCodec<RM690B0_PIXEL_FORMAT_GRAY8>::size;
+
+    default:
+        return 0;
+    }
+}
+
+esp_err_t esp_lcd_panel_rm690b0_convert_pixels(rm690b0_pixel_format_t src_format, const void* src,
+                                               rm690b0_pixel_format_t dst_format, void* dst, size_t pixel_count) {
+    ESP_RETURN_ON_FALSE(src && dst, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    const auto* in = static_cast<const uint8_t*>(src);
+    auto* out = static_cast<uint8_t*>(dst);
+
+    switch (src_format) {
+    case RM690B0_PIXEL_FORMAT_RGB565:
+        return convert_from<RM690B0_PIXEL_FORMAT_RGB565>(in, dst_format, out, pixel_count);
+
+    case RM690B0_PIXEL_FORMAT_RGB666:
+        return convert_from<RM690B0_PIXEL_FORMAT_RGB666>(in, dst_format, out, pixel_count);
+
+    case RM690B0_PIXEL_FORMAT_RGB888:
+        return convert_from<RM690B0_PIXEL_FORMAT_RGB888>(in, dst_format, out, pixel_count);
+
+    case RM690B0_PIXEL_FORMAT_ARGB8888:
+        return convert_from<RM690B0_PIXEL_FORMAT_ARGB8888>(in, dst_format, out, pixel_count);
+
+    case RM690B0_PIXEL_FORMAT_GRAY8:
+        return convert_from<RM690B0_PIXEL_FORMAT_GRAY8>(in, dst_format, out, pixel_count);
+
+    default:
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+}
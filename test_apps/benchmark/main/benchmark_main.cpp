@@ -0,0 +1,324 @@
+// On-target benchmark: full-frame and small-rect flush rates, commands per draw and heap allocations per
+// flush, for each color depth and bus clock. Prints one summary line and one stats JSON line per run.
+// Then LVGL's frame rate and CPU load through the driver's LVGL adapter and through the usual flush callback.
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cinttypes>
+#include <cstdio>
+
+#include "driver/spi_master.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_rm690b0.h"
+#include "esp_lcd_rm690b0_lvgl.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "lvgl.h"
+
+constexpr auto TAG = "rm690b0_benchmark";
+
+namespace {
+    // The LilyGo T4 S3, see the README
+    constexpr spi_host_device_t host = SPI3_HOST;
+    constexpr gpio_num_t cs_gpio = GPIO_NUM_11;
+    constexpr gpio_num_t reset_gpio = GPIO_NUM_13;
+    constexpr gpio_num_t en_gpio = GPIO_NUM_9;
+    constexpr int width = 600; // Landscape: the panel is 450 x 600, swapped
+    constexpr int height = 450;
+    constexpr int x_gap = 16;
+    constexpr size_t stream_buffer_size = 32 * 1024;
+
+    constexpr std::array<uint8_t, 3> depths = {16, 18, 24};
+    constexpr std::array<uint32_t, 3> clocks_hz = {40'000'000, 60'000'000, 80'000'000};
+
+    constexpr int full_frames = 60;
+    constexpr int small_rects = 1000;
+    constexpr int small_rect = 32;
+    constexpr TickType_t draw_timeout = pdMS_TO_TICKS(1000);
+
+    // LVGL runs at 16 bpp, its RGB565, on the fastest clock, with the adapter's default draw buffers:
+    // two of a tenth of the screen each, in internal RAM
+    constexpr uint32_t lvgl_clock_hz = 80'000'000;
+    constexpr int lvgl_frames = 120;
+    constexpr int lvgl_buffer_rows = height / 10;
+    constexpr int square = 64; // Moved by 2 pixels a frame, so its areas stay aligned without the adapter
+
+    std::atomic<uint32_t> allocations = 0;
+    SemaphoreHandle_t draw_done = nullptr;
+
+    IRAM_ATTR bool on_draw_done([[maybe_unused]] esp_lcd_panel_handle_t panel, [[maybe_unused]] void* user_ctx) {
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(draw_done, &woken);
+        return woken == pdTRUE;
+    }
+
+    // Draw and wait for the last pixel to be on the wire
+    esp_err_t draw(esp_lcd_panel_handle_t panel, const int x_start, const int y_start, const int x_end,
+                   const int y_end, const void* pixels) {
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_draw_bitmap(panel, x_start, y_start, x_end, y_end, pixels), TAG,
+                            "draw failed");
+        ESP_RETURN_ON_FALSE(xSemaphoreTake(draw_done, draw_timeout) == pdTRUE, ESP_ERR_TIMEOUT, TAG,
+                            "draw never finished");
+        return ESP_OK;
+    }
+
+    // Pixels that differ, so nothing takes a shortcut for a single color
+    void fill_pattern(uint8_t* pixels, const size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            pixels[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+        }
+    }
+
+    void open_panel(const uint32_t clock_hz, const uint8_t bits_per_pixel, esp_lcd_panel_io_handle_t* io,
+                    esp_lcd_panel_handle_t* panel) {
+        const esp_lcd_panel_io_spi_config_t io_config = {
+            .cs_gpio_num = cs_gpio,
+            .dc_gpio_num = GPIO_NUM_NC,
+            .spi_mode = 0,
+            .pclk_hz = clock_hz,
+            .trans_queue_depth = 10,
+            .lcd_cmd_bits = 32,
+            .lcd_param_bits = 8,
+            .flags = {
+                .quad_mode = 1,
+            },
+        };
+
+        ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi(host, &io_config, io));
+
+        rm960b0_vendor_config_t vendor_config = {
+            .en_gpio_num = en_gpio,
+            .stream_buffer_size = stream_buffer_size,
+            .width = height, // Before swap_xy
+            .height = width,
+        };
+
+        const esp_lcd_panel_dev_config_t panel_config = {
+            .reset_gpio_num = reset_gpio,
+            .rgb_ele_order = LCD_RGB_ELEMENT_ORDER_RGB,
+            .bits_per_pixel = bits_per_pixel,
+            .vendor_config = &vendor_config,
+        };
+
+        ESP_ERROR_CHECK(esp_lcd_new_panel_rm690b0(*io, &panel_config, panel));
+
+        const rm690b0_event_callbacks_t callbacks = {.on_color_trans_done = on_draw_done};
+
+        ESP_ERROR_CHECK(esp_lcd_panel_reset(*panel));
+        ESP_ERROR_CHECK(esp_lcd_panel_init(*panel));
+        ESP_ERROR_CHECK(esp_lcd_panel_swap_xy(*panel, true));
+        ESP_ERROR_CHECK(esp_lcd_panel_set_gap(*panel, x_gap, 0));
+        ESP_ERROR_CHECK(esp_lcd_panel_rm690b0_register_event_callbacks(*panel, &callbacks, nullptr));
+    }
+
+    void run(const uint32_t clock_hz, const uint8_t bits_per_pixel, const uint8_t* frame, const uint8_t* rect) {
+        esp_lcd_panel_io_handle_t io = nullptr;
+        esp_lcd_panel_handle_t panel = nullptr;
+        open_panel(clock_hz, bits_per_pixel, &io, &panel);
+
+        // Full frames from PSRAM, through the streaming buffers
+        esp_lcd_panel_rm690b0_reset_stats(panel);
+        const uint32_t allocations_before = allocations;
+        int64_t start_us = esp_timer_get_time();
+
+        for (int i = 0; i < full_frames; ++i) {
+            ESP_ERROR_CHECK(draw(panel, 0, 0, width, height, frame));
+        }
+
+        const double fps = full_frames * 1e6 / static_cast<double>(esp_timer_get_time() - start_us);
+
+        // Small rectangles from internal RAM, tiled across the screen like the dirty areas of a UI
+        rm690b0_stats_t frame_stats = {};
+        esp_lcd_panel_rm690b0_get_stats(panel, &frame_stats);
+        start_us = esp_timer_get_time();
+
+        for (int i = 0; i < small_rects; ++i) {
+            constexpr int columns = width / small_rect;
+            constexpr int rows = height / small_rect;
+            const int x = i % columns * small_rect;
+            const int y = i / columns % rows * small_rect;
+            ESP_ERROR_CHECK(draw(panel, x, y, x + small_rect, y + small_rect, rect));
+        }
+
+        const double rects_per_s = small_rects * 1e6 / static_cast<double>(esp_timer_get_time() - start_us);
+        const uint32_t flush_allocations = allocations - allocations_before;
+
+        rm690b0_stats_t stats = {};
+        esp_lcd_panel_rm690b0_get_stats(panel, &stats);
+        const double commands_per_draw = static_cast<double>(stats.command_count - frame_stats.command_count) /
+                                         static_cast<double>(stats.flush_calls - frame_stats.flush_calls);
+
+        std::printf("pclk_hz=%" PRIu32 " bpp=%u fps=%.1f rects_per_s=%.0f cmds_per_draw=%.2f "
+                    "allocs_per_flush=%.3f\n",
+                    clock_hz, static_cast<unsigned>(bits_per_pixel), fps, rects_per_s, commands_per_draw,
+                    static_cast<double>(flush_allocations) / (full_frames + small_rects));
+
+        std::array<char, 512> line{};
+        esp_lcd_panel_rm690b0_format_stats(&stats, line.data(), line.size());
+        std::printf("%s\n", line.data());
+
+        ESP_ERROR_CHECK(esp_lcd_panel_del(panel));
+        ESP_ERROR_CHECK(esp_lcd_panel_io_del(io));
+    }
+
+    uint32_t lvgl_tick_ms() {
+        return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+    }
+
+    // The flush callback most examples use: draw, wait for the last pixel to be on the wire, tell LVGL
+    void naive_flush(lv_display_t* display, const lv_area_t* area, uint8_t* px_map) {
+        auto* panel = static_cast<esp_lcd_panel_handle_t>(lv_display_get_user_data(display));
+        ESP_ERROR_CHECK(draw(panel, area->x1, area->y1, area->x2 + 1, area->y2 + 1, px_map));
+        lv_display_flush_ready(display);
+    }
+
+    // Time the idle task on this core has had, in the run time stats' microseconds
+    configRUN_TIME_COUNTER_TYPE idle_time() {
+        return ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(xPortGetCoreID()));
+    }
+
+    enum class Scene : uint8_t {
+        full,   // The whole screen changes color every frame, ten flushes of a tenth of it
+        square, // A square moves across a still screen, small flushes
+    };
+
+    // Render `lvgl_frames` frames of `scene` and print the frame rate and the CPU load of this core meanwhile
+    void run_scene(lv_display_t* display, const char* flush, const Scene scene) {
+        lv_obj_t* screen = lv_display_get_screen_active(display);
+        lv_obj_t* box = lv_obj_create(screen);
+        lv_obj_set_size(box, square, square);
+        lv_refr_now(display); // The first frame is the whole screen whatever the scene, so it isn't counted
+
+        const configRUN_TIME_COUNTER_TYPE idle_before = idle_time();
+        const int64_t start_us = esp_timer_get_time();
+
+        for (int i = 0; i < lvgl_frames; ++i) {
+            if (scene == Scene::full) {
+                lv_obj_set_style_bg_color(screen, lv_color_hsv_to_rgb(static_cast<uint16_t>(i * 3 % 360), 100, 100),
+                                          LV_PART_MAIN);
+            } else {
+                lv_obj_set_pos(box, i * 2 % (width - square), i * 2 % (height - square));
+            }
+
+            lv_refr_now(display);
+        }
+
+        const auto elapsed_us = static_cast<double>(esp_timer_get_time() - start_us);
+        const auto idle_us = static_cast<double>(idle_time() - idle_before);
+
+        std::printf("lvgl scene=%s flush=%s fps=%.1f cpu_load=%.0f%%\n", scene == Scene::full ? "full" : "square",
+                    flush, lvgl_frames * 1e6 / elapsed_us, 100 * (1 - idle_us / elapsed_us));
+
+        lv_obj_clean(screen);
+    }
+
+    void run_scenes(lv_display_t* display, const char* flush) {
+        run_scene(display, flush, Scene::full);
+        run_scene(display, flush, Scene::square);
+    }
+
+    // The same scenes through the usual flush callback, then through the adapter
+    void run_lvgl() {
+        esp_lcd_panel_io_handle_t io = nullptr;
+        esp_lcd_panel_handle_t panel = nullptr;
+        open_panel(lvgl_clock_hz, 16, &io, &panel);
+
+        lv_init();
+        lv_tick_set_cb(lvgl_tick_ms);
+
+        constexpr size_t buffer_size = static_cast<size_t>(width) * lvgl_buffer_rows * 2;
+        std::array<void*, 2> buffers{};
+        for (void*& buffer : buffers) {
+            buffer = heap_caps_aligned_alloc(LV_DRAW_BUF_ALIGN, buffer_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            assert(buffer);
+        }
+
+        lv_display_t* display = lv_display_create(width, height);
+        assert(display);
+        lv_display_set_color_format(display, LV_COLOR_FORMAT_RGB565);
+        lv_display_set_buffers(display, buffers[0], buffers[1], buffer_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
+        lv_display_set_user_data(display, panel);
+        lv_display_set_flush_cb(display, naive_flush);
+
+        run_scenes(display, "naive");
+
+        lv_display_delete(display);
+        for (void* buffer : buffers) {
+            heap_caps_free(buffer);
+        }
+
+        const rm690b0_lvgl_config_t lvgl_config = {
+            .hor_res = 0,
+            .ver_res = 0,
+            .render_mode = LV_DISPLAY_RENDER_MODE_PARTIAL,
+            .buffer_rows = lvgl_buffer_rows,
+            .single_buffer = false,
+        };
+
+        ESP_ERROR_CHECK(esp_lcd_panel_rm690b0_lvgl_create(panel, &lvgl_config, &display));
+        run_scenes(display, "adapter");
+        lv_display_delete(display);
+
+        lv_deinit();
+        ESP_ERROR_CHECK(esp_lcd_panel_del(panel));
+        ESP_ERROR_CHECK(esp_lcd_panel_io_del(io));
+    }
+}
+
+// Called by the heap on every allocation, with CONFIG_HEAP_USE_HOOKS
+extern "C" IRAM_ATTR void esp_heap_trace_alloc_hook([[maybe_unused]] void* ptr, [[maybe_unused]] size_t size,
+                                                   [[maybe_unused]] uint32_t caps) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+extern "C" IRAM_ATTR void esp_heap_trace_free_hook([[maybe_unused]] void* ptr) {}
+
+extern "C" void app_main() {
+    const spi_bus_config_t bus_config = {
+        .data0_io_num = GPIO_NUM_14,
+        .data1_io_num = GPIO_NUM_10,
+        .sclk_io_num = GPIO_NUM_15,
+        .data2_io_num = GPIO_NUM_16,
+        .data3_io_num = GPIO_NUM_12,
+        .data4_io_num = -1,
+        .data5_io_num = -1,
+        .data6_io_num = -1,
+        .data7_io_num = -1,
+        .max_transfer_sz = static_cast<int>(stream_buffer_size),
+        .flags = SPICOMMON_BUSFLAG_MASTER | SPICOMMON_BUSFLAG_GPIO_PINS,
+    };
+
+    ESP_ERROR_CHECK(spi_bus_initialize(host, &bus_config, SPI_DMA_CH_AUTO));
+
+    draw_done = xSemaphoreCreateBinary();
+    assert(draw_done);
+
+    // Room for the deepest color depth
+    constexpr size_t frame_bytes = static_cast<size_t>(width) * height * 3;
+    constexpr size_t rect_bytes = static_cast<size_t>(small_rect) * small_rect * 3;
+    auto* frame = static_cast<uint8_t*>(heap_caps_malloc(frame_bytes, MALLOC_CAP_SPIRAM));
+    auto* rect = static_cast<uint8_t*>(heap_caps_malloc(rect_bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL));
+    assert(frame && rect);
+
+    fill_pattern(frame, frame_bytes);
+    fill_pattern(rect, rect_bytes);
+
+    for (const uint32_t clock_hz : clocks_hz) {
+        for (const uint8_t bits_per_pixel : depths) {
+            run(clock_hz, bits_per_pixel, frame, rect);
+        }
+    }
+
+    run_lvgl();
+
+    ESP_LOGI(TAG, "Done");
+}